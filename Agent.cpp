@@ -1,8 +1,10 @@
 #include "Agent.h"
+#include "Checkpoint.h"
+#include "Event_stream.h"
 #include "Geometry.h"
+#include "Output.h"
 #include "Utility.h"
 #include "Model.h"
-#include <iostream>
 using namespace std;
 
 static const int initial_health_c {5};
@@ -21,11 +23,12 @@ void Agent::move_to(Point destination_)
 {
 	// tell the agent to move to the destination
 	moving_obj.start_moving(destination_);
+	get_model().activate(get_id());
 	// if moving output proper message and set the state accordingly
 	if (moving_obj.is_currently_moving())
-		cout << get_name() << ": I'm on the way" << endl;
+		Output::chatter() << get_name() << ": I'm on the way\n";
 	else
-		cout << get_name() << ": I'm already there" << endl;
+		Output::chatter() << get_name() << ": I'm already there\n";
 }
 
 // tell this Agent to stop its activity
@@ -33,7 +36,7 @@ void Agent::stop()
 {
 	if (moving_obj.is_currently_moving()) {
 		moving_obj.stop_moving();
-		cout << get_name() << ": I'm stopped" << endl;
+		Output::chatter() << get_name() << ": I'm stopped\n";
 	}
 }
 
@@ -48,39 +51,82 @@ void Agent::take_hit(int attack_strength, shared_ptr<Agent> attacker_ptr)
 
 // update the moving state and Agent state of this object.
 void Agent::update()
+{
+	Movement_e movement;
+	{
+		PROFILE_PHASE(get_model(), MOVEMENT);
+		movement = update_movement(Output::chatter());
+	}
+	record_movement(movement);
+	if (movement == Movement_e::ARRIVAL)
+		get_model().record_arrival();
+	if (movement != Movement_e::NONE)
+		broadcast_current_state();
+	update_behavior();
+}
+
+// Advance the moving state by one step, writing any messages to os.
+// Returns what happened.
+Agent::Movement_e Agent::update_movement(ostream& os)
 {
 	switch(health_state) {
 		case Health_State_e::ALIVE:
 			if (moving_obj.is_currently_moving()) {
-				if (moving_obj.update_location())
-					cout << get_name() << ": I'm there!"<< endl;
-				else
-					cout << get_name() << ": step..." << endl;
-				broadcast_current_state();
+				if (moving_obj.update_location()) {
+					announce_arrival(os);
+					return Movement_e::ARRIVAL;
+				}
+				os << get_name() << ": step...\n";
+				return Movement_e::STEP;
 			}
 			break;
 		case Health_State_e::DEAD:
 		default:
 			break;
 	}
-	
+	return Movement_e::NONE;
+}
+
+void Agent::record_movement(Movement_e movement) const
+{
+	Event_stream* events = get_model().get_event_stream();
+	if (!events)
+		return;
+	if (movement == Movement_e::STEP)
+		events->record_moved(get_symbol(), moving_obj.get_current_location());
+	else if (movement == Movement_e::ARRIVAL)
+		events->record_arrived(get_symbol(), moving_obj.get_current_location());
+}
+
+// move as that many updates would, but without any messages;
+// returns the number of the update in which we arrived, or 0
+int Agent::fast_forward(int ticks)
+{
+	if (!is_alive())
+		return 0;
+	return moving_obj.fast_forward(ticks);
+}
+
+void Agent::announce_arrival(ostream& os) const
+{
+	os << get_name() << ": I'm there!\n";
 }
 
 // output information about the current state
 void Agent::describe() const
 {
-	cout << get_name() << " at " << moving_obj.get_current_location() << endl;
+	Output::events() << get_name() << " at " << moving_obj.get_current_location() << '\n';
 	switch(health_state) {
 		case Health_State_e::ALIVE:
-			cout << "   Health is " << health << endl;
+			Output::events() << "   Health is " << health << '\n';
 			if (moving_obj.is_currently_moving()) {
-				cout << "   Moving at speed "<< moving_obj.get_current_speed() << " to " << moving_obj.get_current_destination() << endl;
+				Output::events() << "   Moving at speed "<< moving_obj.get_current_speed() << " to " << moving_obj.get_current_destination() << '\n';
 			} else {
-				cout << "   Stopped" << endl;
+				Output::events() << "   Stopped\n";
 			}
 			break;
 		case Health_State_e::DEAD:
-			cout << "   Is dead" << endl; // not expected to be output
+			Output::events() << "   Is dead\n"; // not expected to be output
 		default:
 			break;
 	}
@@ -92,8 +138,9 @@ void Agent::broadcast_current_state()
 {
 	switch(health_state) {
 		case Health_State_e::ALIVE:
-			Model::get_Model().notify_location(get_name(), moving_obj.get_current_location());
-			Model::get_Model().notify_health(get_name(), health);
+			get_model().update_agent_location(get_id(), moving_obj.get_current_location());
+			get_model().notify_location(get_symbol(), moving_obj.get_current_location());
+			get_model().notify_health(get_symbol(), health);
 			break;
 		case Health_State_e::DEAD:
 		default:
@@ -123,11 +170,42 @@ void Agent::lose_health(int attack_strength)
 	if (health <= 0) {
 		health_state = Health_State_e::DEAD;
 		moving_obj.stop_moving();
-		cout << get_name() << ": Arrggh!" << endl;
-		Model::get_Model().remove_agent(shared_from_this());
-		Model::get_Model().notify_gone(get_name());
+		Output::chatter() << get_name() << ": Arrggh!\n";
+		if (Event_stream* events = get_model().get_event_stream())
+			events->record_died(get_symbol());
+		get_model().record_death();
+		get_model().remove_agent(shared_from_this());
+		get_model().notify_gone(get_symbol());
 	} else {
-		Model::get_Model().notify_health(get_name(), health);
-		cout << get_name() << ": Ouch!" << endl;
+		get_model().notify_health(get_symbol(), health);
+		Output::chatter() << get_name() << ": Ouch!\n";
+		if (Event_stream* events = get_model().get_event_stream())
+			events->record_hit(get_symbol(), health);
 	}
 }
+
+// save the moving state and health
+void Agent::save_state(Checkpoint_record& record, const Checkpoint_links& links) const
+{
+	Point location = moving_obj.get_current_location();
+	Point destination = moving_obj.get_current_destination();
+	Cartesian_vector delta = moving_obj.get_current_delta();
+	record.x = location.x;
+	record.y = location.y;
+	record.speed = moving_obj.get_current_speed();
+	record.destination_x = destination.x;
+	record.destination_y = destination.y;
+	record.delta_x = delta.delta_x;
+	record.delta_y = delta.delta_y;
+	record.moving = moving_obj.is_currently_moving();
+	record.health = health;
+}
+
+// restore the moving state and health
+void Agent::restore_state(const Checkpoint_record& record, const Checkpoint_links& links)
+{
+	moving_obj.restore(record.moving != 0, Point(record.x, record.y), record.speed,
+		Point(record.destination_x, record.destination_y), Cartesian_vector(record.delta_x, record.delta_y));
+	health = record.health;
+	health_state = health > 0 ? Health_State_e::ALIVE : Health_State_e::DEAD;
+}
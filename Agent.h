@@ -10,12 +10,14 @@ it becomes dead, and finally disappearing.
 #include "Moving_object.h"
 #include "Sim_object.h"
 
+#include <iosfwd>
 #include <memory>
 #include <string>
 
 // forward declarations
 struct Structure;
 struct Point;
+class Ledger;
 
 class Agent : public Sim_object, public std::enable_shared_from_this<Agent> {
 public:
@@ -46,7 +48,33 @@ public:
 	virtual void take_hit(int attack_strength, std::shared_ptr<Agent> attacker_ptr);
 	
 	// update the moving state and Agent state of this object.
+	// this is update_movement followed by update_behavior.
 	void update() override;
+
+	// what happened in one step of update_movement
+	enum class Movement_e { NONE, STEP, ARRIVAL };
+	// Advance the moving state by one step, writing any messages to os.
+	// Touches nothing but this Agent, so Model can run it for different Agents at once.
+	// If the Agent moved (took a step or arrived), its state needs broadcasting.
+	Movement_e update_movement(std::ostream& os);
+	// record what update_movement did in the Model's event stream, if it has one
+	void record_movement(Movement_e movement) const;
+	// update whatever the Agent does besides moving; Agents do nothing else
+	virtual void update_behavior() {}
+	// an Agent has something to do while it is alive and moving
+	bool has_pending_work() const override
+		{return is_alive() && is_moving();}
+	// an Agent only moves, so any number of ticks can be skipped
+	int get_skippable_ticks(int ticks) const override
+		{return ticks;}
+	// move as that many updates would; see Moving_object::fast_forward
+	int fast_forward(int ticks) override;
+	// write the message for arriving at the destination to os
+	void announce_arrival(std::ostream& os) const;
+	// keep the moving state in slot of kinematics from now on, or with a null
+	// kinematics, take it back; see Moving_object
+	void bind_kinematics(Kinematics* kinematics, int slot)
+		{moving_obj.bind(kinematics, slot);}
 	
 	// output information about the current state
 	void describe() const override;
@@ -54,6 +82,10 @@ public:
 	// ask Model to broadcast our current state to all Views
 	void broadcast_current_state() override;
 
+	// save and restore the moving state and health
+	void save_state(Checkpoint_record& record, const Checkpoint_links& links) const override;
+	void restore_state(const Checkpoint_record& record, const Checkpoint_links& links) override;
+
 	/* Fat Interface for derived classes */
 	// Throws exception that an Agent cannot work.
 	virtual void start_working(std::shared_ptr<Structure>, std::shared_ptr<Structure>);
@@ -61,7 +93,17 @@ public:
 	// Throws exception that an Agent cannot attack.
 	virtual void start_attacking(std::shared_ptr<Agent>);
 
+	// a Structure this Agent is waiting at may have something for it now; Agents don't wait
+	virtual void wake_up() {}
+	// enter the transfer with a Structure this Agent will make on its turn this tick,
+	// if any, in ledger; Agents don't make any
+	virtual void plan_transfer(Ledger& ledger) const {}
+
 protected:
+
+	// the number of the next ticks update in which the Agent will arrive, or 0 if none
+	int get_ticks_to_arrival(int ticks) const
+		{return moving_obj.get_ticks_to_arrival(ticks);}
 	
 	// calculate loss of health due to hit.
 	// if health decreases to zero or negative, Agent state becomes Dead, and any movement is stopped.
@@ -1,4 +1,5 @@
 #include "Agent_factory.h"
+#include "Object_pool.h"
 #include "Peasant.h"
 #include "Warriors.h"
 #include "Utility.h"
@@ -10,11 +11,11 @@ const char* const unknown_type {"Trying to create agent of unknown type!"};
 shared_ptr<Agent> create_agent(const string& name, const string& type, Point location)
 {
 	if (type == "Peasant") {
-		return shared_ptr<Agent>(new Peasant(name, location));
+		return allocate_shared<Peasant>(Pool_allocator<Peasant>(), name, location);
 	} else if (type == "Soldier") {
-		return shared_ptr<Agent>(new Soldier(name, location));
+		return allocate_shared<Soldier>(Pool_allocator<Soldier>(), name, location);
 	} else if (type == "Archer") {
-		return shared_ptr<Agent>(new Archer(name, location));
+		return allocate_shared<Archer>(Pool_allocator<Archer>(), name, location);
 	} else {
 		throw Error(unknown_type);
 	}
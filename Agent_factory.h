@@ -10,7 +10,8 @@ struct Agent;
 
 // Create and return the pointer to the specified Agent type. If the type
 // is unrecognized, throws Error("Trying to create agent of unknown type!")
-// The Agent is allocated with new, so some other component is resposible for deleting it.
+// The Agent and its shared_ptr control block are allocated together from a pool
+// for its type, and go back to the pool when the last shared_ptr to it is gone.
 std::shared_ptr<Agent> create_agent(const std::string& name, const std::string& type, Point location);
 
 #endif
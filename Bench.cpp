@@ -0,0 +1,256 @@
+/*
+Benchmark driver for the simulation engine; built by "make bench".
+
+It builds a synthetic world of a given number of objects, runs Model::update
+a fixed number of ticks with the chatter off, and reports the agent-ticks per
+second, the median and 99th percentile tick latency, and the peak resident set size,
+along with how many arrivals and deaths there were, to show the work was done.
+The world is made with a fixed random seed, so every run of the same arguments
+does exactly the same work.
+
+Scenarios:
+	economy	- mostly Peasants, each working between a random Farm and a random Town_Hall
+	combat	- mostly Soldiers and Archers, the Soldiers marching across the world through the Archers
+	view	- the economy world with the map, health and amounts views open and drawn every tick
+	all		- each of the above in turn
+Each scenario is run in a child process of its own, so that the peak resident set
+size reported for it is its own, rather than the biggest of those run before it.
+
+Usage: benchexe [scenario [objects [density [ticks [threads]]]]]
+density is the number of objects per 100 square units (a 10 x 10 square); threads is
+passed to Model::set_thread_count.
+*/
+
+#include "Agent.h"
+#include "Agent_factory.h"
+#include "Geometry.h"
+#include "Model.h"
+#include "Output.h"
+#include "Structure.h"
+#include "Structure_factory.h"
+#include "Utility.h"
+#include "Views.h"
+
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+using namespace std;
+
+// defaults for the command line arguments
+static const char* const def_scenario_c {"all"};
+static const int def_objects_c {10000};
+static const double def_density_c {4.};
+static const int def_ticks_c {100};
+static const int def_threads_c {1};
+
+// what the world is made of, as fractions of the objects
+struct Mix {
+	double farms;
+	double town_halls;
+	double peasants;
+	double soldiers;
+	// and the rest are archers
+};
+static const Mix economy_mix_c {.05, .05, .85, .05};
+static const Mix combat_mix_c {.02, .03, .05, .45};
+
+struct Bench_result {
+	int objects;
+	long long agent_ticks;
+	double seconds;
+	double p50_ms;
+	double p99_ms;
+	Tick_totals totals;
+};
+
+Bench_result run_scenario(const string& scenario, int objects, double density, int ticks, int threads);
+void populate(Model& model, const Mix& mix, int objects, double side, bool march);
+double percentile(vector<double> values, double fraction);
+long peak_rss_kb();
+void print_result(const string& scenario, const Bench_result& result);
+bool run_in_child(const string& scenario, int objects, double density, int ticks, int threads);
+
+int main(int argc, char* argv[])
+{
+	string scenario = argc > 1 ? argv[1] : def_scenario_c;
+	int objects = argc > 2 ? atoi(argv[2]) : def_objects_c;
+	double density = argc > 3 ? atof(argv[3]) : def_density_c;
+	int ticks = argc > 4 ? atoi(argv[4]) : def_ticks_c;
+	int threads = argc > 5 ? atoi(argv[5]) : def_threads_c;
+	if (objects < 1 || density <= 0. || ticks < 1 || threads < 1) {
+		cerr << "Usage: benchexe [economy|combat|view|all [objects [density [ticks [threads]]]]]" << endl;
+		return 1;
+	}
+	vector<string> scenarios;
+	if (scenario == "all")
+		scenarios = {"economy", "combat", "view"};
+	else if (scenario == "economy" || scenario == "combat" || scenario == "view")
+		scenarios = {scenario};
+	else {
+		cerr << "Unknown scenario: " << scenario << endl;
+		return 1;
+	}
+
+	cout << "objects: " << objects << ", density: " << density << " per 100 square units, ticks: "
+		<< ticks << ", threads: " << threads << endl;
+	cout << left << setw(10) << "scenario" << right << setw(10) << "objects" << setw(16) << "agent-ticks/s"
+		<< setw(10) << "p50 ms" << setw(10) << "p99 ms" << setw(16) << "peak RSS KB"
+		<< setw(10) << "arrivals" << setw(8) << "deaths" << endl;
+	for (const string& name : scenarios) {
+		if (!run_in_child(name, objects, density, ticks, threads))
+			return 1;
+	}
+	return 0;
+}
+
+// run the scenario and print its result in a process of its own, and return whether that worked
+bool run_in_child(const string& scenario, int objects, double density, int ticks, int threads)
+{
+	cout.flush();
+	pid_t pid = fork();
+	if (pid < 0) {
+		cerr << "Could not start a process for " << scenario << endl;
+		return false;
+	}
+	if (pid == 0) {
+		int status = 0;
+		try {
+			print_result(scenario, run_scenario(scenario, objects, density, ticks, threads));
+		} catch (exception& e) {
+			cerr << e.what() << endl;
+			status = 1;
+		}
+		cout.flush();
+		// leave the parent's buffers and static objects to the parent
+		_exit(status);
+	}
+	int status;
+	while (waitpid(pid, &status, 0) < 0) {
+		if (errno != EINTR) {
+			cerr << "Lost the process for " << scenario << endl;
+			return false;
+		}
+	}
+	return WIFEXITED(status) && WEXITSTATUS(status) == 0;
+}
+
+// build the world for the scenario and time ticks updates of it
+Bench_result run_scenario(const string& scenario, int objects, double density, int ticks, int threads)
+{
+	Model model(false);
+	// what the world prints goes through its own Output, kept quiet below
+	Output_scope scope(model.get_output());
+	model.set_chatter(false);
+	model.set_thread_count(threads);
+	double side = 10. * sqrt(objects / density);
+	bool views = scenario == "view";
+	populate(model, scenario == "combat" ? combat_mix_c : economy_mix_c, objects, side, scenario == "combat");
+	if (views) {
+		model.attach("map", make_shared<Map>(model.get_symbols()));
+		model.attach("health", make_shared<Health>(model.get_symbols()));
+		model.attach("amounts", make_shared<Amounts>(model.get_symbols()));
+	}
+
+	// the views draw to the Output, so keep it quiet while we time them
+	Output_suppressor quiet;
+	Bench_result result {objects, 0, 0., 0., 0., Tick_totals()};
+	vector<double> latencies;
+	for (int i = 0; i < ticks; ++i) {
+		result.agent_ticks += model.get_agent_count();
+		auto start = chrono::steady_clock::now();
+		model.update();
+		if (views)
+			model.draw_all_views();
+		chrono::duration<double> elapsed = chrono::steady_clock::now() - start;
+		result.seconds += elapsed.count();
+		latencies.push_back(elapsed.count() * 1000.);
+	}
+	result.p50_ms = percentile(latencies, .5);
+	result.p99_ms = percentile(latencies, .99);
+	result.totals = model.get_totals();
+	return result;
+}
+
+// add the objects to the model, spread at random over a square of the given side,
+// and set the agents going: Peasants to work, Soldiers marching across the world
+void populate(Model& model, const Mix& mix, int objects, double side, bool march)
+{
+	mt19937 generator(1);
+	uniform_real_distribution<double> coordinate(0., side);
+	auto random_point = [&]() {return Point(coordinate(generator), coordinate(generator));};
+
+	int farms = max(1, int(objects * mix.farms));
+	int town_halls = max(1, int(objects * mix.town_halls));
+	int peasants = int(objects * mix.peasants);
+	int soldiers = int(objects * mix.soldiers);
+	int archers = max(0, objects - farms - town_halls - peasants - soldiers);
+
+	vector<shared_ptr<Structure>> farm_ptrs, town_hall_ptrs;
+	for (int i = 0; i < farms; ++i) {
+		farm_ptrs.push_back(create_structure("F" + to_string(i), "Farm", random_point()));
+		model.add_structure(farm_ptrs.back());
+	}
+	for (int i = 0; i < town_halls; ++i) {
+		town_hall_ptrs.push_back(create_structure("T" + to_string(i), "Town_Hall", random_point()));
+		model.add_structure(town_hall_ptrs.back());
+	}
+
+	// the agents say what they're doing as they're told to do it
+	Output_suppressor quiet;
+	uniform_int_distribution<int> pick_farm(0, farms - 1), pick_town_hall(0, town_halls - 1);
+	for (int i = 0; i < peasants; ++i) {
+		shared_ptr<Agent> peasant = create_agent("P" + to_string(i), "Peasant", random_point());
+		model.add_agent(peasant);
+		peasant->start_working(farm_ptrs[pick_farm(generator)], town_hall_ptrs[pick_town_hall(generator)]);
+	}
+	for (int i = 0; i < soldiers; ++i) {
+		Point start = random_point();
+		shared_ptr<Agent> soldier = create_agent("S" + to_string(i), "Soldier", start);
+		model.add_agent(soldier);
+		if (march)
+			soldier->move_to(Point(side - start.x, side - start.y));
+	}
+	for (int i = 0; i < archers; ++i)
+		model.add_agent(create_agent("A" + to_string(i), "Archer", random_point()));
+}
+
+// the value that the given fraction of the values are no greater than
+double percentile(vector<double> values, double fraction)
+{
+	if (values.empty())
+		return 0.;
+	size_t index = min(values.size() - 1, size_t(fraction * values.size()));
+	nth_element(values.begin(), values.begin() + index, values.end());
+	return values[index];
+}
+
+// the most memory this process has had resident so far; as each scenario is run in
+// a process of its own, it is that scenario's peak
+long peak_rss_kb()
+{
+	rusage usage;
+	getrusage(RUSAGE_SELF, &usage);
+	return usage.ru_maxrss;
+}
+
+void print_result(const string& scenario, const Bench_result& result)
+{
+	double rate = result.seconds > 0. ? result.agent_ticks / result.seconds : 0.;
+	cout << left << setw(10) << scenario << right << setw(10) << result.objects
+		<< fixed << setprecision(0) << setw(16) << rate
+		<< setprecision(3) << setw(10) << result.p50_ms << setw(10) << result.p99_ms
+		<< setw(16) << peak_rss_kb()
+		<< setw(10) << result.totals.arrivals << setw(8) << result.totals.deaths << endl;
+}
@@ -0,0 +1,105 @@
+#include "Checkpoint.h"
+#include "Utility.h"
+
+#include <cstring>
+#include <fstream>
+using namespace std;
+
+// error messages
+const char* const cant_write {"Could not write checkpoint file!"};
+const char* const cant_read {"Could not read checkpoint file!"};
+const char* const not_checkpoint {"Not a checkpoint file!"};
+const char* const wrong_version {"Unsupported checkpoint version!"};
+const char* const corrupt {"Checkpoint file is corrupt!"};
+
+static const char magic_c[4] {'P', '5', 'C', 'K'};
+
+Checkpoint_writer::Checkpoint_writer(int time_)
+:
+time {time_}
+{ }
+
+// add a record for an object with this name and type; the rest of the record is up to the object
+Checkpoint_record& Checkpoint_writer::add_record(const string& name, const string& type)
+{
+	Checkpoint_record record;
+	memset(&record, 0, sizeof(record));
+	record.name_offset = add_string(name);
+	record.name_length = uint32_t(name.size());
+	record.type_offset = add_string(type);
+	record.type_length = uint32_t(type.size());
+	record.link_1 = record.link_2 = checkpoint_no_link_c;
+	records.push_back(record);
+	return records.back();
+}
+
+// write the header, the records and the strings
+void Checkpoint_writer::write(const string& filename) const
+{
+	Checkpoint_header header;
+	memset(&header, 0, sizeof(header));
+	memcpy(header.magic, magic_c, sizeof(magic_c));
+	header.version = checkpoint_version_c;
+	header.time = time;
+	header.record_count = uint32_t(records.size());
+	header.strings_size = uint32_t(strings.size());
+
+	ofstream file(filename.c_str(), ios::binary | ios::trunc);
+	if (!file)
+		throw Error(cant_write);
+	file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+	if (!records.empty())
+		file.write(reinterpret_cast<const char*>(records.data()), records.size() * sizeof(Checkpoint_record));
+	file.write(strings.data(), strings.size());
+	if (!file)
+		throw Error(cant_write);
+}
+
+uint32_t Checkpoint_writer::add_string(const string& str)
+{
+	uint32_t offset = uint32_t(strings.size());
+	strings += str;
+	return offset;
+}
+
+// read the whole file with one read, then copy the parts out and check them
+Checkpoint_reader::Checkpoint_reader(const string& filename)
+{
+	ifstream file(filename.c_str(), ios::binary);
+	if (!file)
+		throw Error(cant_read);
+	file.seekg(0, ios::end);
+	streamoff file_size = file.tellg();
+	file.seekg(0, ios::beg);
+	if (file_size < streamoff(sizeof(Checkpoint_header)))
+		throw Error(not_checkpoint);
+	vector<char> image(static_cast<size_t>(file_size));
+	if (!file.read(image.data(), image.size()))
+		throw Error(cant_read);
+
+	memcpy(&header, image.data(), sizeof(header));
+	if (memcmp(header.magic, magic_c, sizeof(magic_c)) != 0)
+		throw Error(not_checkpoint);
+	if (header.version != checkpoint_version_c)
+		throw Error(wrong_version);
+	size_t records_size = size_t(header.record_count) * sizeof(Checkpoint_record);
+	if (image.size() != sizeof(header) + records_size + header.strings_size)
+		throw Error(corrupt);
+
+	records.resize(header.record_count);
+	if (records_size)
+		memcpy(records.data(), image.data() + sizeof(header), records_size);
+	strings.assign(image.data() + sizeof(header) + records_size, header.strings_size);
+
+	for (const Checkpoint_record& record : records) {
+		if (uint64_t(record.name_offset) + record.name_length > header.strings_size ||
+			uint64_t(record.type_offset) + record.type_length > header.strings_size)
+			throw Error(corrupt);
+		if (record.kind != checkpoint_structure_c && record.kind != checkpoint_agent_c)
+			throw Error(corrupt);
+		for (int32_t link : {record.link_1, record.link_2}) {
+			if (link != checkpoint_no_link_c && (link < 0 || uint32_t(link) >= header.record_count))
+				throw Error(corrupt);
+		}
+	}
+}
@@ -0,0 +1,125 @@
+#ifndef CHECKPOINT_H
+#define CHECKPOINT_H
+/*
+A checkpoint is a binary image of a whole world, written by Model::save_checkpoint
+and read back by Model::load_checkpoint.
+
+The file is laid out so that it could be memory-mapped and used in place:
+	a Checkpoint_header,
+	one fixed-size Checkpoint_record per object, alphabetically by name,
+	a block of characters holding the objects' names and type names.
+Everything is stored in the machine's own byte order. Objects refer to each other
+(a Peasant to its source and destination, a Warrior to its target) by record number,
+and records refer to their strings by offset and length into the character block.
+The version number is increased whenever the layout, or what the saved state means,
+changes; files of any other version are refused. The versions so far:
+	1	the first
+	2	Farms produce only when they're looked at; the layout is unchanged, and a
+		Farm's amount is still what it has on hand at the saved time. What it
+		has produced up to isn't saved: it starts again from the saved time.
+		Peasants can wait at an empty source; whether one is waiting isn't
+		saved either
+Nothing is saved about who is waiting on a Structure: a Peasant that was waiting
+when the world was saved tries again on the first tick after it's loaded, and
+waits again if there's still nothing, so the Structures' waiters are rebuilt then.
+
+Each kind of Sim_object fills in and reads back the parts of a record it needs,
+using a Checkpoint_links to turn the objects it refers to into record numbers and back.
+Checkpoint_writer and Checkpoint_reader deal with the file itself.
+*/
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+class Sim_object;
+
+const uint32_t checkpoint_version_c = 2;
+// record number used for "no object"
+const int32_t checkpoint_no_link_c = -1;
+// kinds of record
+const uint8_t checkpoint_structure_c = 0;
+const uint8_t checkpoint_agent_c = 1;
+
+struct Checkpoint_header {
+	char magic[4];
+	uint32_t version;
+	int32_t time;
+	uint32_t record_count;
+	uint32_t strings_size;
+	uint32_t reserved;
+};
+
+struct Checkpoint_record {
+	uint32_t name_offset;
+	uint32_t name_length;
+	uint32_t type_offset;
+	uint32_t type_length;
+	double x;				// location
+	double y;
+	double amount;			// food on hand or being carried
+	double speed;
+	double destination_x;
+	double destination_y;
+	double delta_x;			// movement per update
+	double delta_y;
+	int32_t health;
+	int32_t state;			// working or attacking state
+	int32_t link_1;			// source, or target
+	int32_t link_2;			// destination
+	uint8_t kind;			// checkpoint_structure_c or checkpoint_agent_c
+	uint8_t moving;
+	uint8_t padding[6];
+};
+
+// turns the objects that objects refer to into record numbers and back
+class Checkpoint_links {
+public:
+	virtual ~Checkpoint_links() {}
+	// the record number of object, or checkpoint_no_link_c if object is null
+	virtual int32_t record_of(const Sim_object* object) const = 0;
+	// the object in record; throws Error("Checkpoint file is corrupt!") if there is no such record
+	// returns nullptr for checkpoint_no_link_c
+	virtual std::shared_ptr<Sim_object> object_at(int32_t record) const = 0;
+};
+
+// collects the records for a world and writes them out
+class Checkpoint_writer {
+public:
+	Checkpoint_writer(int time_);
+	// add a record for an object with this name and type; the rest of the record is up to the object
+	Checkpoint_record& add_record(const std::string& name, const std::string& type);
+	// throws Error("Could not write checkpoint file!") if the file can't be written
+	void write(const std::string& filename) const;
+private:
+	int time;
+	std::vector<Checkpoint_record> records;
+	std::string strings;
+
+	uint32_t add_string(const std::string& str);
+};
+
+// reads a checkpoint file into memory in one go and checks that it makes sense
+class Checkpoint_reader {
+public:
+	// throws Error if the file can't be read, isn't a checkpoint of our version, or is corrupt
+	Checkpoint_reader(const std::string& filename);
+
+	int get_time() const
+		{return header.time;}
+	int get_record_count() const
+		{return int(header.record_count);}
+	const Checkpoint_record& get_record(int i) const
+		{return records[i];}
+	std::string get_name(const Checkpoint_record& record) const
+		{return strings.substr(record.name_offset, record.name_length);}
+	std::string get_type(const Checkpoint_record& record) const
+		{return strings.substr(record.type_offset, record.type_length);}
+
+private:
+	Checkpoint_header header;
+	std::vector<Checkpoint_record> records;
+	std::string strings;
+};
+
+#endif
@@ -2,7 +2,9 @@
 
 #include "Agent.h"
 #include "Agent_factory.h"
+#include "Journal.h"
 #include "Model.h"
+#include "Output.h"
 #include "View.h"
 #include "Views.h"
 #include "Structure.h"
@@ -12,15 +14,9 @@
 #include <algorithm>
 #include <cassert>
 #include <iostream>
+#include <sstream>
 using namespace std;
 
-// types for the command map
-using CommandFunction = void (Controller::*)();
-using Command_Map_t = map<string, CommandFunction>;
-
-using AgentCommand = void (Controller::*)(shared_ptr<Agent>);
-using Agent_Command_Map_t = map<string, AgentCommand>;
-
 
 // string constants for error messages
 const char* const expected_int {"Expected an integer!"};
@@ -33,6 +29,16 @@ const char* const no_object_of_name {"No object of that name!"};
 const char* const no_view {"No view of that name is open!"};
 const char* const map_str {"map"};
 const char* const no_map {"No map view is open!"};
+const char* const positive_threads {"Number of threads must be positive!"};
+const char* const positive_ticks {"Number of ticks must be positive!"};
+const char* const expected_on_off {"Expected on or off!"};
+const char* const replay_diverged {"Replay diverged from journal!"};
+const char* const expected_clear {"Expected clear!"};
+const char* const expected_level {"Expected chatter, events or errors!"};
+const char* const expected_fd_or_off {"Expected a file descriptor or off!"};
+const char* const no_values_view {"Expected health or amounts!"};
+const char* const expected_listing {"Expected all, summary, top or bottom!"};
+const char* const positive_listing {"Number of values listed must be positive!"};
 
 // ==================================
 // === HELPER FUNCTION PROTOTYPES ===
@@ -42,22 +48,41 @@ void check_cin(string message);
 bool string_is_alnum(const string &str);
 bool char_is_alnum(char c);
 Point read_Point();
+bool read_optional_int(int& value);
+bool is_end_of_line();
+bool is_go_command(const string& command, int& ticks);
+bool read_optional_word(string& word);
 
 // ===================
 // === DEFINTIIONS ===
 // ===================
 
-void Controller::run()
+Controller::Controller()
+:
+model(Model::get_Model())
 {
-	Command_Map_t command_map;
-	Agent_Command_Map_t agent_command_map;
+	populate_commands();
+}
 
-	// populate the commands
+Controller::Controller(Model& model_)
+:
+model(model_)
+{
+	populate_commands();
+}
+
+// defined here, where Journal is complete
+Controller::~Controller()
+{ }
+
+void Controller::populate_commands()
+{
 	// view:
 	command_map["default"] = &Controller::default_fn;
 	command_map["size"] = &Controller::size;
 	command_map["zoom"] = &Controller::zoom;
 	command_map["pan"] = &Controller::pan;
+	command_map["list"] = &Controller::list;
 
 	// program-wide commands
 	command_map["status"] = &Controller::status;
@@ -65,6 +90,17 @@ void Controller::run()
 	command_map["go"] = &Controller::go;
 	command_map["build"] = &Controller::build;
 	command_map["train"] = &Controller::train;
+	command_map["threads"] = &Controller::threads;
+	command_map["chatter"] = &Controller::chatter;
+	command_map["production"] = &Controller::production;
+	command_map["delta"] = &Controller::delta;
+	command_map["output"] = &Controller::output;
+	command_map["events"] = &Controller::events;
+	command_map["save"] = &Controller::save;
+	command_map["load"] = &Controller::load;
+	command_map["journal"] = &Controller::journal;
+	command_map["replay"] = &Controller::replay;
+	command_map["stats"] = &Controller::stats;
 
 	// new p5 commands
 	command_map["open"] = &Controller::open;
@@ -75,52 +111,89 @@ void Controller::run()
 	agent_command_map["work"] = &Controller::work;
 	agent_command_map["attack"] = &Controller::attack;
 	agent_command_map["stop"] = &Controller::stop;
+}
 
-	// command loop!
+void Controller::run()
+{
+	// command loop! what we print goes through the Model's Output
+	Output_scope scope(model.get_output());
 	string first_word;
 	while(true) {
+		Output::events() << "\nTime " << model.get_time() << ": Enter command: ";
+		int command_time = model.get_time();
+		bool journaled = false;
+		if (journal_ptr)
+			journal_ptr->begin_command();
 		try {
-		cout << "\nTime " << Model::get_Model().get_time() << ": Enter command: ";
 		cin >> first_word;
 		if (first_word == "quit") {
-			cout << "Done" << endl;
+			Output::events() << "Done\n";
 			return;
 		}
-		// test if word is name of an agent
-		if (Model::get_Model().is_agent_present(first_word)) {
-			shared_ptr<Agent> agent = Model::get_Model().get_agent_ptr(first_word);
-			assert(agent->is_alive());
-			string cmd_name;
-			cin >> cmd_name;
-			// find command from appropriate command map
-			auto cmd_fn = agent_command_map.find(cmd_name);
-			// test it was actually found
-			if(cmd_fn == agent_command_map.end())
-				throw Error(unrecognized_cmd);
-			// cmd_fn is an iterator, so call its mapped value (function)
-			auto mem = cmd_fn->second;
-			(this->*mem)(agent);
-		} else {
-			// test to see if the command is in the map
-			auto cmd_fn = command_map.find(first_word);
-			// test if it was there
-			if(cmd_fn == command_map.end())
-				throw Error(unrecognized_cmd);
-			auto mem = cmd_fn->second;
-			(this->*mem)();
-		}
+		// a command that fails part way may still have changed things, so it's journaled too
+		journaled = is_journaled(first_word);
+		execute_command(first_word);
 		}
 		// end of try block
 		catch(exception& e) {
-			cout << e.what() << endl;
+			Output::errors() << e.what() << '\n';
+			if (journaled && journal_ptr)
+				journal_ptr->record_command(command_time);
 			clear_and_skip_line();
+			continue;
 		} catch(...) {
-			cout << "Unknown exception caught!" << endl;
+			Output::errors() << "Unknown exception caught!\n";
+			if (journaled && journal_ptr)
+				journal_ptr->record_command(command_time);
 			clear_and_skip_line();
+			continue;
 		}
+		if (!journal_ptr)
+			continue;
+		if (journaled)
+			journal_ptr->record_command(command_time);
+		else
+			journal_ptr->skip_command();
+	}
+}
+
+// carry out the command starting with first_word; the rest of it is read from cin
+void Controller::execute_command(const string& first_word)
+{
+	// test if word is name of an agent
+	if (model.is_agent_present(first_word)) {
+		shared_ptr<Agent> agent = model.get_agent_ptr(first_word);
+		assert(agent->is_alive());
+		string cmd_name;
+		cin >> cmd_name;
+		// find command from appropriate command map
+		auto cmd_fn = agent_command_map.find(cmd_name);
+		// test it was actually found
+		if(cmd_fn == agent_command_map.end())
+			throw Error(unrecognized_cmd);
+		// cmd_fn is an iterator, so call its mapped value (function)
+		auto mem = cmd_fn->second;
+		(this->*mem)(agent);
+	} else {
+		// test to see if the command is in the map
+		auto cmd_fn = command_map.find(first_word);
+		// test if it was there
+		if(cmd_fn == command_map.end())
+			throw Error(unrecognized_cmd);
+		auto mem = cmd_fn->second;
+		(this->*mem)();
 	}
 }
 
+// everything but unrecognized commands and the journal commands themselves goes in the journal
+bool Controller::is_journaled(const string& first_word) const
+{
+	// a file descriptor means nothing to a later run
+	if (first_word == "journal" || first_word == "replay" || first_word == "events")
+		return false;
+	return model.is_agent_present(first_word) || command_map.count(first_word);
+}
+
 void clear_and_skip_line()
 {
 	cin.clear();
@@ -130,22 +203,23 @@ void clear_and_skip_line()
 // View factory
 shared_ptr<View> Controller::create_view(const string& name)
 {
+	const Symbol_table& symbols = model.get_symbols();
 	if (name == "map") {
-		return shared_ptr<View>(new Map);
+		return shared_ptr<View>(new Map(symbols));
 	} else if (name == "health") {
-		return shared_ptr<View>(new Health);
+		return shared_ptr<View>(new Health(symbols));
 	} else if (name == "amounts") {
-		return shared_ptr<View>(new Amounts);
+		return shared_ptr<View>(new Amounts(symbols));
 	} else {
 		// local view for agent
-		if (!Model::get_Model().is_name_in_use(name))
+		if (!model.is_name_in_use(name))
 			throw Error(no_object_of_name);
-		if (Model::get_Model().is_agent_present(name)) {
-			shared_ptr<Agent> agent = Model::get_Model().get_agent_ptr(name);
-			return shared_ptr<View>(new Local(agent->get_location(), name));
+		if (model.is_agent_present(name)) {
+			shared_ptr<Agent> agent = model.get_agent_ptr(name);
+			return shared_ptr<View>(new Local(agent->get_location(), agent->get_symbol(), symbols));
 		} else {
-			shared_ptr<Structure> structure = Model::get_Model().get_structure_ptr(name);
-			return shared_ptr<View>(new Local(structure->get_location(), name));
+			shared_ptr<Structure> structure = model.get_structure_ptr(name);
+			return shared_ptr<View>(new Local(structure->get_location(), structure->get_symbol(), symbols));
 		}
 	}
 }
@@ -161,7 +235,7 @@ void Controller::open()
 		throw Error(view_already_exists);
 	shared_ptr<View> new_view = create_view(view_name);
 	views_in_use[view_name] = true;
-	Model::get_Model().attach(view_name, new_view);
+	model.attach(view_name, new_view);
 }
 
 void Controller::close()
@@ -172,13 +246,13 @@ void Controller::close()
 	if (!views_in_use[view_name])
 		throw Error(no_view);
 	views_in_use[view_name] = false;
-	Model::get_Model().detach(view_name);
+	model.detach(view_name);
 }
 
 void Controller::default_fn()
 {
 	check_if_not_open(map_str, no_map);
-	shared_ptr<View> view = Model::get_Model().get_view(map_str);
+	shared_ptr<View> view = model.get_view(map_str);
 	view->set_defaults();
 }
 
@@ -188,7 +262,7 @@ void Controller::size()
 	int size;
 	cin >> size;
 	check_cin(expected_int);
-	shared_ptr<View> view = Model::get_Model().get_view(map_str);
+	shared_ptr<View> view = model.get_view(map_str);
 	view->set_size(size);
 }
 
@@ -198,7 +272,7 @@ void Controller::zoom()
 	double scale;
 	cin >> scale;
 	check_cin(expected_double);
-	shared_ptr<View> view = Model::get_Model().get_view(map_str);
+	shared_ptr<View> view = model.get_view(map_str);
 	view->set_scale(scale);
 }
 
@@ -213,10 +287,38 @@ void check_cin(string message)
 void Controller::pan()
 {
 	check_if_not_open(map_str, no_map);
-	shared_ptr<View> view = Model::get_Model().get_view(map_str);
+	shared_ptr<View> view = model.get_view(map_str);
 	view->set_origin(read_Point());
 }
 
+// list health|amounts all|summary|top K|bottom K chooses what that view lists when it's drawn
+void Controller::list()
+{
+	string view_name;
+	cin >> view_name;
+	if (view_name != "health" && view_name != "amounts")
+		throw Error(no_values_view);
+	check_if_not_open(view_name, no_view);
+	string setting;
+	cin >> setting;
+	View::Listing_e listing;
+	int count = 0;
+	if (setting == "all") {
+		listing = View::Listing_e::ALL;
+	} else if (setting == "summary") {
+		listing = View::Listing_e::SUMMARY;
+	} else if (setting == "top" || setting == "bottom") {
+		listing = setting == "top" ? View::Listing_e::TOP : View::Listing_e::BOTTOM;
+		cin >> count;
+		check_cin(expected_int);
+		if (count <= 0)
+			throw Error(positive_listing);
+	} else {
+		throw Error(expected_listing);
+	}
+	model.get_view(view_name)->set_listing(listing, count);
+}
+
 void Controller::check_if_not_open(const string& name, const string& error_msg)
 {
 	if (!views_in_use[name])
@@ -226,28 +328,286 @@ void Controller::check_if_not_open(const string& name, const string& error_msg)
 // program-wide commands
 void Controller::status()
 {
-	Model::get_Model().describe();
+	model.describe();
 }
 
 void Controller::show()
 {
-	Model::get_Model().draw_all_views();
+	model.draw_all_views();
 }
 
+// go runs one tick, go N runs N ticks in a row.
+// If chatter is off, a summary of what happened is printed at the end.
 void Controller::go()
 {
-	Model::get_Model().update();
+	// the count is optional; whatever else follows go is left to be read as the next
+	// command, as several commands can be given on one line, e.g. "go go go"
+	int ticks = 1;
+	if (read_optional_int(ticks) && ticks < 1)
+		throw Error(positive_ticks);
+
+	model.clear_totals();
+	model.run(ticks);
+
+	if (!model.is_chatty()) {
+		const Tick_totals& totals = model.get_totals();
+		Output::events() << "Ran " << totals.ticks << " ticks: " << totals.arrivals << " arrivals, "
+			<< totals.deaths << " deaths, " << totals.food_moved << " food moved\n";
+	}
+}
+
+// if the rest of the line starts with an integer, read it into value and return true;
+// otherwise leave the line alone and return false
+bool read_optional_int(int& value)
+{
+	while (cin.peek() == ' ' || cin.peek() == '\t')
+		cin.get();
+	int next = cin.peek();
+	if (!isdigit(next) && next != '-' && next != '+')
+		return false;
+	cin >> value;
+	check_cin(expected_int);
+	return true;
+}
+
+// if the rest of the line starts with a word, read it into word and return true;
+// otherwise leave the line alone and return false
+bool read_optional_word(string& word)
+{
+	if (is_end_of_line())
+		return false;
+	cin >> word;
+	return true;
 }
+
+// skip any blanks, and return whether that's all there was left of the line
+bool is_end_of_line()
+{
+	while (cin.peek() == ' ' || cin.peek() == '\t')
+		cin.get();
+	int next = cin.peek();
+	return next == '\n' || next == EOF;
+}
+
+// stats prints where the ticks have spent their time; stats clear starts over
+void Controller::stats()
+{
+	string setting;
+	if (!read_optional_word(setting)) {
+		model.describe_stats();
+		return;
+	}
+	if (setting != "clear")
+		throw Error(expected_clear);
+	model.clear_stats();
+}
+
+// chatter on|off turns the messages objects print while updating on or off
+void Controller::chatter()
+{
+	string setting;
+	cin >> setting;
+	if (setting == "on")
+		model.set_chatter(true);
+	else if (setting == "off")
+		model.set_chatter(false);
+	else
+		throw Error(expected_on_off);
+}
+// production on|off turns the Farms' report of how much they have on each tick on or off
+void Controller::production()
+{
+	string setting;
+	cin >> setting;
+	if (setting == "on")
+		model.set_production_reports(true);
+	else if (setting == "off")
+		model.set_production_reports(false);
+	else
+		throw Error(expected_on_off);
+}
+// delta on|off makes show draw only what has changed in each view since it last drew, or everything again
+void Controller::delta()
+{
+	string setting;
+	cin >> setting;
+	if (setting == "on")
+		model.set_delta_drawing(true);
+	else if (setting == "off")
+		model.set_delta_drawing(false);
+	else
+		throw Error(expected_on_off);
+}
+// output chatter|events|errors prints only what's at that level or above from now on
+void Controller::output()
+{
+	string setting;
+	cin >> setting;
+	if (setting == "chatter")
+		model.get_output().set_level(Output::Level_e::CHATTER);
+	else if (setting == "events")
+		model.get_output().set_level(Output::Level_e::EVENTS);
+	else if (setting == "errors")
+		model.get_output().set_level(Output::Level_e::ERRORS);
+	else
+		throw Error(expected_level);
+}
+// events N records what happens in a binary event stream written to the file descriptor N,
+// one the program was started with, e.g. with 3>events.bin; events off stops recording
+void Controller::events()
+{
+	int fd;
+	if (read_optional_int(fd)) {
+		if (fd < 0)
+			throw Error(expected_fd_or_off);
+		model.open_event_stream(fd);
+		return;
+	}
+	string setting;
+	cin >> setting;
+	if (setting != "off")
+		throw Error(expected_fd_or_off);
+	model.close_event_stream();
+}
+// save <file> writes the whole world to a checkpoint file
+void Controller::save()
+{
+	string filename;
+	cin >> filename;
+	model.save_checkpoint(filename);
+}
+
+// load <file> replaces the whole world with the one saved in a checkpoint file
+void Controller::load()
+{
+	string filename;
+	cin >> filename;
+	model.load_checkpoint(filename);
+}
+
+// journal <file> starts appending the commands carried out to a journal file;
+// journal off stops
+void Controller::journal()
+{
+	string filename;
+	cin >> filename;
+	// stop the old journal first, so that the new one sees cin as it is
+	journal_ptr.reset();
+	if (filename != "off")
+		journal_ptr.reset(new Journal(filename, cin));
+}
+
+// replay <file> carries out the commands in a journal file as fast as possible,
+// printing nothing. Each command has to come up at the same time, relative to the
+// first one, as it did when it was journaled; if not, the replay stops.
+// Since nothing is printed, the chatter is kept off meanwhile, and a run of go
+// commands is carried out as one, so that Model::run can skip over whatever it can;
+// the chatter is left on or off as the journal leaves it.
+void Controller::replay()
+{
+	string filename;
+	cin >> filename;
+	vector<Journal_entry> entries = read_journal(filename);
+	if (entries.empty())
+		return;
+
+	// read each command from its own line, and put cin back however we leave
+	struct Input_switch {
+		Input_switch() : saved(cin.rdbuf()) {}
+		~Input_switch() {cin.rdbuf(saved); cin.clear();}
+		streambuf* saved;
+	} input_switch;
+	Output_suppressor quiet;
+	struct Chatter_switch {
+		Chatter_switch(Model& model_) : model(model_), chatter(model.is_chatter_on()) {model.set_chatter(false);}
+		~Chatter_switch() {model.set_chatter(chatter);}
+		Model& model;
+		bool chatter;
+	} chatter_switch(model);
+	int start_time = model.get_time();
+	for (size_t i = 0; i < entries.size(); ++i) {
+		const Journal_entry& entry = entries[i];
+		if (model.get_time() - start_time != entry.time - entries.front().time)
+			throw Error(replay_diverged);
+		int command_time = model.get_time();
+		// take in the go commands that follow, as long as each comes up when the one before it is done
+		int ticks;
+		if (is_go_command(entry.command, ticks)) {
+			size_t last = i;
+			int last_ticks = ticks;
+			int next_ticks;
+			while (last + 1 < entries.size() && entries[last + 1].time - entries[last].time == last_ticks
+				&& is_go_command(entries[last + 1].command, next_ticks)) {
+				++last;
+				last_ticks = next_ticks;
+				ticks += next_ticks;
+			}
+			model.clear_totals();
+			try {
+				model.run(ticks);
+			} catch(exception&) { }
+			for (; i <= last && journal_ptr; ++i)
+				journal_ptr->append(command_time + entries[i].time - entry.time, entries[i].command);
+			i = last;
+			continue;
+		}
+		istringstream line(entry.command);
+		cin.rdbuf(line.rdbuf());
+		cin.clear();
+		string first_word;
+		cin >> first_word;
+		// commands that failed when journaled fail the same way now
+		try {
+			execute_command(first_word);
+		} catch(exception&) { }
+		if (first_word == "chatter") {
+			chatter_switch.chatter = model.is_chatter_on();
+			model.set_chatter(false);
+		}
+		if (journal_ptr)
+			journal_ptr->append(command_time, entry.command);
+	}
+}
+
+// is the command a go that can't fail, and if so, for how many ticks?
+bool is_go_command(const string& command, int& ticks)
+{
+	istringstream iss(command);
+	string word;
+	iss >> word;
+	if (word != "go")
+		return false;
+	if (!(iss >> ticks)) {
+		ticks = 1;
+		return iss.eof();
+	}
+	iss >> ws;
+	return ticks > 0 && iss.eof();
+}
+
+// set how many threads Model uses for each update; with more than 1, only the Agents'
+// movement and the settling of the food transfers run in parallel, the rest of the
+// tick still runs on one thread; 1 gives the usual sequential update
+void Controller::threads()
+{
+	int thread_count;
+	cin >> thread_count;
+	check_cin(expected_int);
+	if (thread_count < 1)
+		throw Error(positive_threads);
+	model.set_thread_count(thread_count);
+}
+
 // throws an error if the name is less than 2 characters,
 // if a name was unable to be read to cin, or if the name
 // isn't alphanumeric
-void check_name(string name)
+void check_name(const Model& model, string name)
 {
 	const int min_chars_c {2};
 
 	bool too_short = name.length() < min_chars_c;
 	bool not_alnum = !string_is_alnum(name);
-	if (too_short || not_alnum || Model::get_Model().is_name_in_use(name))
+	if (too_short || not_alnum || model.is_name_in_use(name))
 		throw Error(invalid_name);
 }
 
@@ -266,22 +626,22 @@ void Controller::build()
 {
 	string name, type;
 	cin >> name;
-	check_name(name);
+	check_name(model, name);
 	cin >> type;
 	Point location = read_Point();
 	shared_ptr<Structure> new_structure = create_structure(name, type, location);
-	Model::get_Model().add_structure(new_structure);
+	model.add_structure(new_structure);
 }
 
 void Controller::train()
 {
 	string name, type;
 	cin >> name;
-	check_name(name);
+	check_name(model, name);
 	cin >> type;
 	Point location = read_Point();
 	shared_ptr<Agent> new_agent = create_agent(name, type, location);
-	Model::get_Model().add_agent(new_agent);
+	model.add_agent(new_agent);
 }
 
 // agent commands
@@ -305,9 +665,9 @@ void Controller::work(shared_ptr<Agent> agent)
 {
 	string destination_str, source_str;
 	cin >> source_str;
-	shared_ptr<Structure> source = Model::get_Model().get_structure_ptr(source_str);
+	shared_ptr<Structure> source = model.get_structure_ptr(source_str);
 	cin >> destination_str;
-	shared_ptr<Structure> destination = Model::get_Model().get_structure_ptr(destination_str);
+	shared_ptr<Structure> destination = model.get_structure_ptr(destination_str);
 	agent->start_working(source, destination);
 }
 
@@ -315,7 +675,7 @@ void Controller::attack(shared_ptr<Agent> agent)
 {
 	string name;
 	cin >> name;
-	shared_ptr<Agent> victim = Model::get_Model().get_agent_ptr(name);
+	shared_ptr<Agent> victim = model.get_agent_ptr(name);
 	agent->start_attacking(victim);
 }
 
@@ -2,30 +2,52 @@
 #define CONTROLLER_H
 /* Controller
 This class is responsible for controlling the Model and View according to interactions
-with the user.
+with the user. Each Controller runs one Model: the default one unless it's given another.
+It can also keep a journal of the commands it carries out, and replay a journal
+without printing anything; see Journal.h.
 */
 
 #include <memory>
 #include <map>
+#include <string>
 
 // forward declarations
 struct View;
 struct Agent;
+class Model;
+class Journal;
 
 class Controller {
 public:
+	// run the default Model
+	Controller();
+	// run the supplied Model
+	explicit Controller(Model& model_);
+	~Controller();
 	
 	// run the program by acccepting user commands
 	void run();
 
 private:
 
+	// the commands, by name
+	using Command_fn_t = void (Controller::*)();
+	using Agent_command_fn_t = void (Controller::*)(std::shared_ptr<Agent>);
+	std::map<std::string, Command_fn_t> command_map;
+	std::map<std::string, Agent_command_fn_t> agent_command_map;
+	void populate_commands();
+	// carry out the command starting with first_word; the rest of it is read from cin
+	void execute_command(const std::string& first_word);
+	// should the command starting with first_word go in the journal?
+	bool is_journaled(const std::string& first_word) const;
+
 	// command functions by category
 	// view:
 	void default_fn();
 	void size();
 	void zoom();
 	void pan();
+	void list();
 	// new p5 functionality
 	void open();
 	void close();
@@ -36,6 +58,17 @@ private:
 	void go();
 	void build();
 	void train();
+	void threads();
+	void chatter();
+	void production();
+	void delta();
+	void output();
+	void events();
+	void save();
+	void load();
+	void journal();
+	void replay();
+	void stats();
 
 	// agent commands
 	void move(std::shared_ptr<Agent>);
@@ -50,6 +83,10 @@ private:
 	void check_if_not_open(const std::string& name, const std::string& error_msg);
 	// an std::map to easily know which types of views are being used
 	std::map<std::string, bool> views_in_use;
+	// the world we're controlling
+	Model& model;
+	// where the commands are being journaled; null if they aren't
+	std::unique_ptr<Journal> journal_ptr;
 };
 
 #endif
@@ -0,0 +1,138 @@
+#include "Entity_store.h"
+
+#include "Agent.h"
+#include "Sim_object.h"
+#include "Structure.h"
+
+#include <algorithm>
+#include <cassert>
+using namespace std;
+
+// return the ID of the named object, or no_id_c if there is none
+int Entity_store::find(const string& name) const
+{
+	auto itr = name_index.find(name);
+	return itr == name_index.end() ? no_id_c : itr->second;
+}
+
+bool Entity_store::contains(const string& name, Kind kind) const
+{
+	int id = find(name);
+	return id != no_id_c && slots[id].kind == kind;
+}
+
+// add a new object; assumes none with the same name. Returns its ID.
+int Entity_store::insert(shared_ptr<Sim_object> object, Kind kind)
+{
+	int id;
+	if (free_ids.empty()) {
+		id = int(slots.size());
+		slots.push_back(Slot());
+	} else {
+		id = free_ids.back();
+		free_ids.pop_back();
+	}
+	slots[id].object = object;
+	slots[id].kind = kind;
+	slots[id].live = true;
+
+	name_index.insert(make_pair(object->get_name(), id));
+	insert_ordered(ordered_ids, id);
+	ranks_stale = true;
+	insert_ordered(ids_of_kind(kind), id);
+	return id;
+}
+
+// remove the object with this ID; its slot is recycled once no walk is in progress
+void Entity_store::erase(int id)
+{
+	assert(slots[id].live);
+	slots[id].live = false;
+	name_index.erase(slots[id].object->get_name());
+	remove_ordered(ids_of_kind(slots[id].kind), id);
+	// the update order can't change under a walk, so hold on to the slot until it's over
+	if (walk_depth > 0)
+		erased_during_walk.push_back(id);
+	else
+		release(id);
+}
+
+// remove every object; not allowed while a walk is in progress
+void Entity_store::clear()
+{
+	assert(walk_depth == 0);
+	slots.clear();
+	free_ids.clear();
+	name_index.clear();
+	ordered_ids.clear();
+	structure_ids.clear();
+	agent_ids.clear();
+	ranks_stale = true;
+}
+
+// the position of the object in get_ordered_ids()
+int Entity_store::get_rank(int id) const
+{
+	if (ranks_stale) {
+		ranks.resize(slots.size());
+		for (size_t i = 0; i < ordered_ids.size(); ++i)
+			ranks[ordered_ids[i]] = int(i);
+		ranks_stale = false;
+	}
+	return ranks[id];
+}
+
+bool Entity_store::comes_before(int lhs, int rhs) const
+{
+	return slots[lhs].object->get_name() < slots[rhs].object->get_name();
+}
+
+shared_ptr<Structure> Entity_store::get_structure(int id) const
+{
+	assert(slots[id].kind == Kind::STRUCTURE);
+	return static_pointer_cast<Structure>(slots[id].object);
+}
+
+shared_ptr<Agent> Entity_store::get_agent(int id) const
+{
+	assert(slots[id].kind == Kind::AGENT);
+	return static_pointer_cast<Agent>(slots[id].object);
+}
+
+void Entity_store::end_walk()
+{
+	assert(walk_depth > 0);
+	if (--walk_depth > 0)
+		return;
+	for (int id : erased_during_walk)
+		release(id);
+	erased_during_walk.clear();
+}
+
+// insert id into an alphabetically ordered list of IDs
+void Entity_store::insert_ordered(vector<int>& ids, int id)
+{
+	const string& name = slots[id].object->get_name();
+	auto itr = lower_bound(ids.begin(), ids.end(), name,
+		[this](int lhs, const string& rhs) {return slots[lhs].object->get_name() < rhs;});
+	ids.insert(itr, id);
+}
+
+// remove id from an alphabetically ordered list of IDs
+void Entity_store::remove_ordered(vector<int>& ids, int id)
+{
+	const string& name = slots[id].object->get_name();
+	auto itr = lower_bound(ids.begin(), ids.end(), name,
+		[this](int lhs, const string& rhs) {return slots[lhs].object->get_name() < rhs;});
+	assert(itr != ids.end() && *itr == id);
+	ids.erase(itr);
+}
+
+// take the slot out of the update order and hand it back for reuse
+void Entity_store::release(int id)
+{
+	remove_ordered(ordered_ids, id);
+	ranks_stale = true;
+	slots[id].object.reset();
+	free_ids.push_back(id);
+}
@@ -0,0 +1,120 @@
+#ifndef ENTITY_STORE_H
+#define ENTITY_STORE_H
+/*
+Entity_store is the container Model keeps its Sim_objects in.
+Every object lives in exactly one slot of a contiguous vector and is identified
+by the integer ID of that slot. A single hash index maps names to IDs, and
+per-kind ID lists (Structures and Agents) let Model walk just one kind of object.
+All of the ID lists are kept in alphabetical order of the objects' names, so
+iterating them gives the same order the old std::map registries did.
+
+Erasing an object while its ID list is being walked (e.g. an Agent dying during
+Model::update) is allowed: the object is taken out of the name index and the
+kind list right away, but its slot stays reserved until the walk is over, so
+the walk neither skips nor repeats anybody and IDs are never reused mid-walk.
+*/
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// forward declarations
+class Sim_object;
+class Structure;
+class Agent;
+
+class Entity_store {
+public:
+	enum class Kind { STRUCTURE, AGENT };
+	// returned by find if there's no object of that name
+	static const int no_id_c = -1;
+
+	// return the ID of the named object, or no_id_c if there is none
+	int find(const std::string& name) const;
+	// is there a live object of this name, optionally also of this kind?
+	bool contains(const std::string& name) const
+		{return find(name) != no_id_c;}
+	bool contains(const std::string& name, Kind kind) const;
+
+	// add a new object; assumes none with the same name. Returns its ID.
+	int insert(std::shared_ptr<Sim_object> object, Kind kind);
+	// remove the object with this ID; its slot is recycled once no walk is in progress
+	void erase(int id);
+	// remove every object; not allowed while a walk is in progress
+	void clear();
+
+	// true if id refers to an object that has not been erased
+	bool is_live(int id) const
+		{return slots[id].live;}
+	Kind get_kind(int id) const
+		{return slots[id].kind;}
+	const std::shared_ptr<Sim_object>& get(int id) const
+		{return slots[id].object;}
+	std::shared_ptr<Structure> get_structure(int id) const;
+	std::shared_ptr<Agent> get_agent(int id) const;
+
+	// one more than the largest ID handed out so far, for sizing arrays indexed by ID
+	int get_capacity() const
+		{return int(slots.size());}
+
+	// IDs of all live objects, alphabetical by name
+	// while a walk is in progress, this may also contain IDs of erased objects
+	const std::vector<int>& get_ordered_ids() const
+		{return ordered_ids;}
+	// the position of the object in get_ordered_ids(); the alphabetical order of two
+	// objects is the order of their ranks
+	int get_rank(int id) const;
+	// does the object with ID lhs come before the one with ID rhs alphabetically? Unlike
+	// comparing ranks, this never has to recompute them after an insertion
+	bool comes_before(int lhs, int rhs) const;
+	// IDs of the live objects of one kind, alphabetical by name
+	const std::vector<int>& get_ids(Kind kind) const
+		{return kind == Kind::AGENT ? agent_ids : structure_ids;}
+
+	// bracket a walk over get_ordered_ids() during which objects may be erased
+	void begin_walk()
+		{++walk_depth;}
+	void end_walk();
+
+	// begins a walk when created and ends it when destroyed, even by an exception
+	class Walk {
+	public:
+		Walk(Entity_store& store_) : store(store_)
+			{store.begin_walk();}
+		~Walk()
+			{store.end_walk();}
+	private:
+		Entity_store& store;
+	};
+
+private:
+	struct Slot {
+		std::shared_ptr<Sim_object> object;
+		Kind kind;
+		bool live;
+	};
+
+	std::vector<Slot> slots;
+	std::vector<int> free_ids;
+	std::unordered_map<std::string, int> name_index;
+	std::vector<int> ordered_ids;
+	// the rank of each ID; recomputed when needed after ordered_ids changes
+	mutable std::vector<int> ranks;
+	mutable bool ranks_stale = false;
+	std::vector<int> structure_ids;
+	std::vector<int> agent_ids;
+
+	// number of walks in progress, and objects erased during them
+	int walk_depth = 0;
+	std::vector<int> erased_during_walk;
+
+	std::vector<int>& ids_of_kind(Kind kind)
+		{return kind == Kind::AGENT ? agent_ids : structure_ids;}
+	// insert or remove id in an alphabetically ordered list of IDs
+	void insert_ordered(std::vector<int>& ids, int id);
+	void remove_ordered(std::vector<int>& ids, int id);
+	// hand the slot back for reuse
+	void release(int id);
+};
+
+#endif
@@ -0,0 +1,261 @@
+#include "Event_stream.h"
+#include "Utility.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <unistd.h>
+using namespace std;
+
+static const char magic_c[] {'P', '5', 'E', 'V'};
+static const char version_c {1};
+// what's recorded is written out once there's this much of it
+static const int flush_size_c {1 << 16};
+// the type, tick and ID
+static const int record_header_size_c {9};
+static const int max_record_size_c {0xffff};
+
+Event_stream::Event_stream(int fd_)
+:
+fd(fd_),
+tick {0},
+record_start {0},
+failed {false}
+{
+	buffer.reserve(flush_size_c + max_record_size_c + 2);
+	buffer.insert(buffer.end(), begin(magic_c), end(magic_c));
+	buffer.push_back(version_c);
+}
+
+// whatever can't be written out now is lost
+Event_stream::~Event_stream()
+{
+	write_out();
+}
+
+void Event_stream::record_named(int id, const char* type_name, const string& name)
+{
+	begin_record(Event_e::NAMED, id);
+	int type_length = int(strlen(type_name));
+	buffer.push_back(char(type_length));
+	buffer.insert(buffer.end(), type_name, type_name + type_length);
+	// a name too long for a record is cut short
+	int name_length = min(int(name.size()), max_record_size_c - record_header_size_c - 1 - type_length);
+	buffer.insert(buffer.end(), name.begin(), name.begin() + name_length);
+	end_record();
+}
+
+void Event_stream::record_moved(int id, Point location)
+{
+	begin_record(Event_e::MOVED, id);
+	put_double(location.x);
+	put_double(location.y);
+	end_record();
+}
+
+void Event_stream::record_arrived(int id, Point location)
+{
+	begin_record(Event_e::ARRIVED, id);
+	put_double(location.x);
+	put_double(location.y);
+	end_record();
+}
+
+void Event_stream::record_attacked(int id, int target_id)
+{
+	begin_record(Event_e::ATTACKED, id);
+	put_int(target_id);
+	end_record();
+}
+
+void Event_stream::record_hit(int id, double health)
+{
+	begin_record(Event_e::HIT, id);
+	put_double(health);
+	end_record();
+}
+
+void Event_stream::record_died(int id)
+{
+	begin_record(Event_e::DIED, id);
+	end_record();
+}
+
+void Event_stream::record_collected(int id, int source_id, double amount)
+{
+	begin_record(Event_e::COLLECTED, id);
+	put_int(source_id);
+	put_double(amount);
+	end_record();
+}
+
+void Event_stream::record_deposited(int id, int destination_id, double amount)
+{
+	begin_record(Event_e::DEPOSITED, id);
+	put_int(destination_id);
+	put_double(amount);
+	end_record();
+}
+
+void Event_stream::record_waiting(int id, int source_id)
+{
+	begin_record(Event_e::WAITING, id);
+	put_int(source_id);
+	end_record();
+}
+
+void Event_stream::record_produced(int id, double amount)
+{
+	begin_record(Event_e::PRODUCED, id);
+	put_double(amount);
+	end_record();
+}
+
+void Event_stream::flush()
+{
+	if (!write_out() || failed)
+		throw Error("Could not write the event stream!");
+}
+
+// write the buffer out and empty it, and return whether it was all written
+bool Event_stream::write_out()
+{
+	size_t written = 0;
+	while (written < buffer.size()) {
+		ssize_t result = write(fd, buffer.data() + written, buffer.size() - written);
+		if (result < 0 && errno == EINTR)
+			continue;
+		if (result <= 0)
+			break;
+		written += size_t(result);
+	}
+	bool all_written = written == buffer.size();
+	buffer.clear();
+	return all_written;
+}
+
+// leave room for the length, which is filled in by end_record
+void Event_stream::begin_record(Event_e type, int id)
+{
+	record_start = int(buffer.size());
+	buffer.push_back(0);
+	buffer.push_back(0);
+	buffer.push_back(char(type));
+	put_int(tick);
+	put_int(id);
+}
+
+void Event_stream::end_record()
+{
+	int length = int(buffer.size()) - record_start - 2;
+	buffer[record_start] = char(length & 0xff);
+	buffer[record_start + 1] = char((length >> 8) & 0xff);
+	// this may be in the middle of a tick, so a failure is only reported by the next flush
+	if (int(buffer.size()) >= flush_size_c && !write_out())
+		failed = true;
+}
+
+void Event_stream::put_int(int value)
+{
+	uint32_t bits = uint32_t(value);
+	for (int i = 0; i < 4; ++i)
+		buffer.push_back(char((bits >> (8 * i)) & 0xff));
+}
+
+void Event_stream::put_double(double value)
+{
+	uint64_t bits;
+	memcpy(&bits, &value, sizeof(bits));
+	for (int i = 0; i < 8; ++i)
+		buffer.push_back(char((bits >> (8 * i)) & 0xff));
+}
+
+// the numbers in a record, from its position pos on
+static int get_int(const vector<char>& record, int pos)
+{
+	uint32_t bits = 0;
+	for (int i = 0; i < 4; ++i)
+		bits |= uint32_t(static_cast<unsigned char>(record[pos + i])) << (8 * i);
+	return int32_t(bits);
+}
+
+static double get_double(const vector<char>& record, int pos)
+{
+	uint64_t bits = 0;
+	for (int i = 0; i < 8; ++i)
+		bits |= uint64_t(static_cast<unsigned char>(record[pos + i])) << (8 * i);
+	double value;
+	memcpy(&value, &bits, sizeof(value));
+	return value;
+}
+
+// the size of the payload of each type of event, but for NAMED's strings
+static const int payload_sizes_c[int(Event_e::NUMBER_OF_EVENTS)] {1, 16, 16, 4, 8, 0, 12, 12, 4, 8};
+
+Event_reader::Event_reader(istream& is_)
+:
+is(is_)
+{
+	char header[sizeof(magic_c) + 1];
+	if (!is.read(header, sizeof(header)) || memcmp(header, magic_c, sizeof(magic_c)) != 0
+		|| header[sizeof(magic_c)] != version_c)
+		throw Error("Not an event stream!");
+}
+
+bool Event_reader::read(Event& event)
+{
+	while (true) {
+		unsigned char length_bytes[2];
+		if (!is.read(reinterpret_cast<char*>(length_bytes), 2)) {
+			if (is.gcount() == 0)
+				return false;
+			throw Error("Event stream is cut short!");
+		}
+		int length = length_bytes[0] | (length_bytes[1] << 8);
+		record.resize(length);
+		if (!is.read(record.data(), length))
+			throw Error("Event stream is cut short!");
+		if (length < record_header_size_c)
+			continue;
+		int type = static_cast<unsigned char>(record[0]);
+		if (type >= int(Event_e::NUMBER_OF_EVENTS) || length < record_header_size_c + payload_sizes_c[type])
+			continue;
+
+		event.type = Event_e(type);
+		event.tick = get_int(record, 1);
+		event.id = get_int(record, 5);
+		const int pos = record_header_size_c;
+		switch (event.type) {
+			case Event_e::NAMED: {
+				int type_length = static_cast<unsigned char>(record[pos]);
+				if (pos + 1 + type_length > length)
+					continue;
+				event.type_name.assign(record.data() + pos + 1, type_length);
+				event.name.assign(record.data() + pos + 1 + type_length, length - pos - 1 - type_length);
+				break;
+			}
+			case Event_e::MOVED:
+			case Event_e::ARRIVED:
+				event.location = Point(get_double(record, pos), get_double(record, pos + 8));
+				break;
+			case Event_e::ATTACKED:
+			case Event_e::WAITING:
+				event.other_id = get_int(record, pos);
+				break;
+			case Event_e::HIT:
+			case Event_e::PRODUCED:
+				event.value = get_double(record, pos);
+				break;
+			case Event_e::COLLECTED:
+			case Event_e::DEPOSITED:
+				event.other_id = get_int(record, pos);
+				event.value = get_double(record, pos + 4);
+				break;
+			case Event_e::DIED:
+			default:
+				break;
+		}
+		return true;
+	}
+}
@@ -0,0 +1,113 @@
+#ifndef EVENT_STREAM_H
+#define EVENT_STREAM_H
+/*
+An Event_stream writes what happens in the simulation as typed binary records,
+for tools that would otherwise have to pick the messages the objects print apart.
+Model keeps one while it's told to (see Model::open_event_stream), and the objects
+record an event at the point where they print the matching message.
+
+The stream starts with the five bytes "P5EV" and the format version, 1, and then
+has one record per event. All numbers are little-endian; a record is:
+	u16		the number of bytes in the rest of the record
+	u8		the type of event
+	i32		the tick it happened in
+	i32		the ID of the object it happened to
+followed by the payload for its type:
+	NAMED		u8 length of the type name, the type name, and the object's name in the
+				rest of the record; the object's ID is this name's ID from now on
+	MOVED		f64 x, f64 y	the Agent took a step, and is now at (x, y)
+	ARRIVED		f64 x, f64 y	the Agent arrived at (x, y)
+	ATTACKED	i32 target ID
+	HIT			f64 health left
+	DIED		nothing
+	COLLECTED	i32 source ID, f64 amount collected
+	DEPOSITED	i32 destination ID, f64 amount deposited
+	WAITING		i32 source ID
+	PRODUCED	f64 amount the Farm now has
+Every object is NAMED before any other event about it: the objects there are when
+the stream is opened are named first, and the ones added later as they are added.
+Events are recorded whether or not the messages are printed: with chatter off,
+and during a replay, too.
+A reader should skip over the rest of a record longer than it expects, and over
+records of types it doesn't know.
+
+An Event_reader reads the records back.
+*/
+#include "Geometry.h"
+
+#include <istream>
+#include <string>
+#include <vector>
+
+enum class Event_e { NAMED, MOVED, ARRIVED, ATTACKED, HIT, DIED, COLLECTED, DEPOSITED, WAITING, PRODUCED, NUMBER_OF_EVENTS };
+
+class Event_stream {
+public:
+	// write to the file descriptor fd, which is left open when the stream is destroyed;
+	// the stream is written out when flushed, or when enough has been recorded
+	explicit Event_stream(int fd_);
+	~Event_stream();
+
+	// the tick the events recorded from now on happen in
+	void set_tick(int tick_)
+		{tick = tick_;}
+
+	void record_named(int id, const char* type_name, const std::string& name);
+	void record_moved(int id, Point location);
+	void record_arrived(int id, Point location);
+	void record_attacked(int id, int target_id);
+	void record_hit(int id, double health);
+	void record_died(int id);
+	void record_collected(int id, int source_id, double amount);
+	void record_deposited(int id, int destination_id, double amount);
+	void record_waiting(int id, int source_id);
+	void record_produced(int id, double amount);
+
+	// write out what has been recorded; will throw Error("Could not write the event stream!")
+	// if it can't be, or if some of what was recorded earlier couldn't be
+	void flush();
+
+private:
+	Event_stream(const Event_stream&) = delete;
+	Event_stream& operator= (const Event_stream&) = delete;
+
+	int fd;
+	int tick;
+	std::vector<char> buffer;
+	int record_start;
+	bool failed;
+
+	bool write_out();
+	void begin_record(Event_e type, int id);
+	void end_record();
+	void put_int(int value);
+	void put_double(double value);
+};
+
+// one event, as read back from a stream
+struct Event {
+	Event_e type;
+	int tick;
+	int id;
+	int other_id;			// the target, source or destination
+	Point location;
+	double value;			// the health or amount
+	std::string type_name;
+	std::string name;
+};
+
+class Event_reader {
+public:
+	// will throw Error("Not an event stream!") if is doesn't start like one
+	explicit Event_reader(std::istream& is_);
+
+	// read the next event into event and return true, or return false at the end;
+	// will throw Error("Event stream is cut short!") if it ends part way through a record
+	bool read(Event& event);
+
+private:
+	std::istream& is;
+	std::vector<char> record;
+};
+
+#endif
@@ -0,0 +1,121 @@
+/*
+Event stream reader; built by "make eventtext".
+
+It reads a binary event stream, as written by the "events" command (see
+Event_stream.h), and prints each event as the message the object printed for it,
+e.g. "Zug: Clang!" or "Farm Rivendale now has 52.00". The objects' other
+messages, and everything else the program printed, aren't in the stream.
+
+Usage: eventtextexe [-t] [file]
+The stream is read from file, or else from the standard input. With -t, the
+events of each tick are headed by a "Time N" line.
+*/
+#include "Event_stream.h"
+#include "Utility.h"
+
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <unordered_map>
+
+using namespace std;
+
+// what each type of Warrior says when it attacks; see Warriors.cpp
+static const unordered_map<string, string> attack_noises_c {{"Soldier", "Clang!"}, {"Archer", "Twang!"}};
+
+struct Named_object {
+	string type_name;
+	string name;
+};
+
+void print_event(const Event& event, const unordered_map<int, Named_object>& objects);
+
+int main(int argc, char* argv[])
+{
+	ios::sync_with_stdio(false);
+	cout.setf(ios::fixed, ios::floatfield);
+	cout.precision(2);
+
+	bool show_ticks = false;
+	int arg = 1;
+	if (arg < argc && string(argv[arg]) == "-t") {
+		show_ticks = true;
+		++arg;
+	}
+	if (argc - arg > 1) {
+		cerr << "Usage: eventtextexe [-t] [file]" << endl;
+		return 1;
+	}
+	ifstream file;
+	if (arg < argc) {
+		file.open(argv[arg], ios::binary);
+		if (!file) {
+			cerr << "Could not open " << argv[arg] << endl;
+			return 1;
+		}
+	}
+	istream& is = arg < argc ? file : cin;
+
+	try {
+		Event_reader reader(is);
+		unordered_map<int, Named_object> objects;
+		Event event;
+		bool any_yet = false;
+		int tick = 0;
+		while (reader.read(event)) {
+			if (event.type == Event_e::NAMED) {
+				objects[event.id] = Named_object {event.type_name, event.name};
+				continue;
+			}
+			if (show_ticks && (!any_yet || event.tick != tick))
+				cout << "Time " << event.tick << '\n';
+			any_yet = true;
+			tick = event.tick;
+			print_event(event, objects);
+		}
+	} catch (Error& error) {
+		cout.flush();
+		cerr << error.what() << endl;
+		return 1;
+	}
+}
+
+void print_event(const Event& event, const unordered_map<int, Named_object>& objects)
+{
+	auto itr = objects.find(event.id);
+	string name = itr == objects.end() ? "#" + to_string(event.id) : itr->second.name;
+	switch (event.type) {
+		case Event_e::MOVED:
+			cout << name << ": step...\n";
+			break;
+		case Event_e::ARRIVED:
+			cout << name << ": I'm there!\n";
+			break;
+		case Event_e::ATTACKED: {
+			auto noise = itr == objects.end() ? attack_noises_c.end() : attack_noises_c.find(itr->second.type_name);
+			cout << name << ": " << (noise == attack_noises_c.end() ? "Attack!" : noise->second) << '\n';
+			break;
+		}
+		case Event_e::HIT:
+			cout << name << ": Ouch!\n";
+			break;
+		case Event_e::DIED:
+			cout << name << ": Arrggh!\n";
+			break;
+		case Event_e::COLLECTED:
+			cout << name << ": Collected " << event.value << '\n';
+			break;
+		case Event_e::DEPOSITED:
+			cout << name << ": Deposited " << event.value << '\n';
+			break;
+		case Event_e::WAITING:
+			cout << name << ": Waiting \n";
+			break;
+		case Event_e::PRODUCED:
+			cout << "Farm " << name << " now has " << event.value << '\n';
+			break;
+		case Event_e::NAMED:
+		default:
+			break;
+	}
+}
@@ -1,6 +1,8 @@
 #include "Farm.h"
+#include "Checkpoint.h"
+#include "Event_stream.h"
 #include "Model.h"
-#include <iostream>
+#include "Output.h"
 using namespace std;
 
 // define constant values
@@ -11,38 +13,124 @@ Farm::Farm(const string& name_, Point location_)
 : 
 Structure(name_, location_),
 amount {def_amount_c},
-production_rate {def_prod_rate_c}
+produced_until {0},
+production_rate {def_prod_rate_c},
+notified_until {-1},
+turn_amount {0},
+turn_time {-1},
+kept_amount {0},
+kept_produced_until {0}
 { }
 
 Farm::~Farm()
 { }
 
-double Farm::withdraw(double amount_to_get)
+void Farm::set_model(Model* model_)
 {
-	if (amount_to_get > amount)
-		amount_to_get = amount;
+	Structure::set_model(model_);
+	produced_until = model_->get_time();
+}
 
-	amount -= amount_to_get;
-	Model::get_Model().notify_amount(get_name(), amount);
+double Farm::withdraw(double amount_to_get)
+{
+	amount_to_get = take(amount_to_get, get_model().get_time_updated(get_id()));
+	notify_amount();
 	return amount_to_get;
 }
 
+double Farm::take(double request, int time_updated)
+{
+	amount = get_amount_at(time_updated);
+	produced_until = time_updated;
+	if (request > amount)
+		request = amount;
+
+	amount -= request;
+	return request;
+}
+
+void Farm::reach_turn(int time)
+{
+	turn_amount = get_amount_at(time);
+	turn_time = time;
+}
+
+void Farm::keep_state()
+{
+	kept_amount = amount;
+	kept_produced_until = produced_until;
+}
+
+void Farm::restore_kept_state()
+{
+	amount = kept_amount;
+	produced_until = kept_produced_until;
+}
+
+// the reports may have been turned off since this Farm was last activated
 void Farm::update()
 {
-	amount += production_rate;
-	cout << "Farm " << get_name() << " now has " << amount << endl;
-	Model::get_Model().notify_amount(get_name(), amount);
+	if (!get_model().are_production_reports_on())
+		return;
+	double now_has = turn_time == get_model().get_time() ? turn_amount : get_current_amount();
+	Output::chatter() << "Farm " << get_name() << " now has " << now_has << '\n';
+	if (Event_stream* events = get_model().get_event_stream())
+		events->record_produced(get_symbol(), now_has);
+	notify_amount();
+}
+
+bool Farm::has_pending_work() const
+{
+	return get_model().are_production_reports_on();
+}
+
+// the amount is worked out when needed, so there's nothing to do but tell the Views
+int Farm::fast_forward(int ticks)
+{
+	notify_amount();
+	return 0;
+}
+
+void Farm::catch_up()
+{
+	if (notified_until != get_model().get_time_updated(get_id()))
+		notify_amount();
+}
+
+// What was produced on each tick is the same, so it's added up in one multiplication,
+// and the amount doesn't depend on how often it has been looked at. For whole-number
+// rates that's exactly what adding tick by tick gives; for others, it may differ from
+// that in the last bits, but the same way however the ticks are run.
+double Farm::get_current_amount() const
+{
+	return get_amount_at(get_model().get_time_updated(get_id()));
+}
+
+void Farm::notify_amount()
+{
+	notified_until = get_model().get_time_updated(get_id());
+	get_model().notify_amount(get_symbol(), get_current_amount());
 }
 
 void Farm::describe() const
 {
-	cout << "Farm ";
+	Output::events() << "Farm ";
 	Structure::describe();
-	cout << "   Food available: " << amount << endl;
+	Output::events() << "   Food available: " << get_current_amount() << '\n';
 }
 
 void Farm::broadcast_current_state()
 {
-	Model::get_Model().notify_amount(get_name(), amount);
+	notify_amount();
 	Structure::broadcast_current_state();
+}
+
+void Farm::save_state(Checkpoint_record& record, const Checkpoint_links& links) const
+{
+	record.amount = get_current_amount();
+}
+
+void Farm::restore_state(const Checkpoint_record& record, const Checkpoint_links& links)
+{
+	amount = record.amount;
 }
\ No newline at end of file
@@ -1,9 +1,16 @@
 #ifndef FARM_H
 #define FARM_H
 /*
-A Farm is a Structure that when updated, increments the amount of food on hand
+A Farm is a Structure that on every tick, increments the amount of food on hand
 by the production rate amount.
 Food can be withdrawn, but no provision is made for depositing any.
+The production isn't added tick by tick, but only when the amount is needed: the
+Farm remembers up to which tick the amount on hand includes the production, and
+adds what has been produced since when it's withdrawn from, described, broadcast,
+saved, or about to be drawn by the Views (catch_up). A Farm is updated only when
+the Model's production reports are on, to print how much it has on each tick; when
+a parallel update settles the tick's withdrawals ahead of time, the amount to
+report is put aside when settling reaches the Farm's turn.
 */
 #include "Structure.h"
 // forward declare Point
@@ -18,17 +25,60 @@ public:
 	// and deducts that amount from the amount on hand
 	double withdraw(double amount_to_get) override;
 
-	//	update adds the production amount to the stored amount
+	// start producing from the Model's current time
+	void set_model(Model* model_) override;
+
+	// update reports the amount on hand
 	void update() override;
+	// the production is worked out when needed, so there's only something to do
+	// if the production is to be reported
+	bool has_pending_work() const override;
+	// reporting looks at nothing else, so it can be done for many ticks at once
+	int get_skippable_ticks(int ticks) const override
+		{return ticks;}
+	int fast_forward(int ticks) override;
+	// tell the Views about the production since they were last told
+	void catch_up() override;
+	void notify_amount() override;
+	// there's new food on every tick, so there's never any need to wait
+	bool add_waiter(std::shared_ptr<Agent> waiter) override
+		{return false;}
 
 	// output information about the current state
 	void describe() const override;
 
 	void broadcast_current_state() override;
+
+	const char* get_type_name() const override
+		{return "Farm";}
+	void save_state(Checkpoint_record& record, const Checkpoint_links& links) const override;
+	void restore_state(const Checkpoint_record& record, const Checkpoint_links& links) override;
+
+protected:
+	double take(double request, int time_updated) override;
+	void reach_turn(int time) override;
+	void keep_state() override;
+	void restore_kept_state() override;
 	
 private:
+	// the amount on hand at the end of tick produced_until
 	double amount;
+	int produced_until;
 	double production_rate;
+	// the tick as of which the Views were last told the amount
+	int notified_until;
+	// the amount on hand at this Farm's turn in tick turn_time, put aside by settling
+	double turn_amount;
+	int turn_time;
+	// amount and produced_until, kept by keep_state
+	double kept_amount;
+	int kept_produced_until;
+
+	// the amount on hand at the end of tick time_updated, counting the production since produced_until
+	double get_amount_at(int time_updated) const
+		{return amount + production_rate * (time_updated - produced_until);}
+	// the amount on hand now
+	double get_current_amount() const;
 };
 
 #endif
@@ -0,0 +1,116 @@
+#include "Journal.h"
+#include "Utility.h"
+
+#include <algorithm>
+#include <cctype>
+#include <sstream>
+using namespace std;
+
+// error messages
+const char* const cant_open_journal {"Could not open journal file!"};
+const char* const cant_read_journal {"Could not read journal file!"};
+const char* const not_journal {"Not a journal file!"};
+
+// turn line breaks and runs of white space into single spaces, and trim the ends
+static string tidy_command(const string& text);
+
+Input_recorder::Input_recorder(istream& is_)
+:
+is(is_),
+source {is_.rdbuf()}
+{
+	setg(&buffer, &buffer, &buffer);
+	is.rdbuf(this);
+}
+
+// a character we've read ahead but nobody has taken goes back where it came from
+Input_recorder::~Input_recorder()
+{
+	if (gptr() < egptr())
+		source->sputbackc(*gptr());
+	is.rdbuf(source);
+}
+
+// return what has been read since the last call;
+// a character read ahead but not yet taken counts as read next time
+string Input_recorder::take()
+{
+	size_t pending = min(size_t(egptr() - gptr()), recorded.size());
+	string taken = recorded.substr(0, recorded.size() - pending);
+	recorded.erase(0, recorded.size() - pending);
+	return taken;
+}
+
+// get the next character from the source, one at a time so that we always know
+// exactly how much has been read
+Input_recorder::int_type Input_recorder::underflow()
+{
+	int_type c = source->sbumpc();
+	if (traits_type::eq_int_type(c, traits_type::eof()))
+		return c;
+	buffer = traits_type::to_char_type(c);
+	recorded += buffer;
+	setg(&buffer, &buffer, &buffer + 1);
+	return c;
+}
+
+Journal::Journal(const string& filename, istream& is)
+:
+file(filename.c_str(), ios::app),
+recorder(is)
+{
+	if (!file)
+		throw Error(cant_open_journal);
+}
+
+// append a line; flushed right away so that the journal survives a crash
+void Journal::append(int time, const string& command)
+{
+	string tidy = tidy_command(command);
+	if (tidy.empty())
+		return;
+	file << time << ' ' << tidy << endl;
+}
+
+// read the entries of a journal file, skipping blank lines
+vector<Journal_entry> read_journal(const string& filename)
+{
+	ifstream file(filename.c_str());
+	if (!file)
+		throw Error(cant_read_journal);
+	vector<Journal_entry> entries;
+	string line;
+	while (getline(file, line)) {
+		istringstream iss(line);
+		Journal_entry entry;
+		if (!(iss >> entry.time)) {
+			if (tidy_command(line).empty())
+				continue;
+			throw Error(not_journal);
+		}
+		getline(iss, entry.command);
+		entry.command = tidy_command(entry.command);
+		if (entry.command.empty())
+			throw Error(not_journal);
+		entries.push_back(entry);
+	}
+	if (file.bad())
+		throw Error(cant_read_journal);
+	return entries;
+}
+
+static string tidy_command(const string& text)
+{
+	string tidy;
+	for (char c : text) {
+		if (isspace(static_cast<unsigned char>(c))) {
+			if (!tidy.empty() && tidy.back() != ' ')
+				tidy += ' ';
+		} else {
+			tidy += c;
+		}
+	}
+	if (!tidy.empty() && tidy.back() == ' ')
+		tidy.pop_back();
+	return tidy;
+}
@@ -0,0 +1,77 @@
+#ifndef JOURNAL_H
+#define JOURNAL_H
+/*
+A journal is an append-only text file recording the commands a Controller carried
+out, one per line, each preceded by the time at which it was carried out:
+	0 Merry work Sunnybrook Shire
+	0 go 3
+	3 Zug attack Bug
+Whatever a command read from the input, even across line breaks, ends up on its line.
+A journal can be replayed into a world in the same state the journal was started
+in (e.g. by loading a checkpoint saved at that point) to do the same things again.
+
+A Journal records a command by watching everything read from an input stream
+while the command is carried out; Input_recorder is the stream buffer that does it.
+read_journal reads a journal file back.
+*/
+#include <fstream>
+#include <istream>
+#include <streambuf>
+#include <string>
+#include <vector>
+
+// a stream buffer that sits in front of an istream's own buffer and
+// remembers every character read through it
+class Input_recorder : public std::streambuf {
+public:
+	// start recording what is read from is
+	Input_recorder(std::istream& is_);
+	// stop recording; is gets its own buffer back
+	~Input_recorder();
+	// return what has been read since the last call
+	std::string take();
+protected:
+	int_type underflow() override;
+private:
+	std::istream& is;
+	std::streambuf* source;
+	char buffer;
+	std::string recorded;
+
+	Input_recorder(const Input_recorder&) = delete;
+	Input_recorder& operator= (const Input_recorder&) = delete;
+};
+
+class Journal {
+public:
+	// start appending the commands read from is to the named file
+	// will throw Error("Could not open journal file!") if the file can't be opened
+	Journal(const std::string& filename, std::istream& is);
+
+	// a new command is about to be read; forget whatever was read before it
+	void begin_command()
+		{recorder.take();}
+	// the command read since begin_command was carried out at time; append it
+	void record_command(int time)
+		{append(time, recorder.take());}
+	// the command read since begin_command isn't to be journaled
+	void skip_command()
+		{recorder.take();}
+	// append a command that didn't come from the input, e.g. one being replayed
+	void append(int time, const std::string& command);
+
+private:
+	std::ofstream file;
+	Input_recorder recorder;
+};
+
+struct Journal_entry {
+	int time;
+	std::string command;
+};
+
+// read the entries of a journal file
+// will throw Error if the file can't be read or isn't a journal
+std::vector<Journal_entry> read_journal(const std::string& filename);
+
+#endif
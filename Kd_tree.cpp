@@ -0,0 +1,26 @@
+#include "Kd_tree.h"
+
+#include <algorithm>
+using namespace std;
+
+// replace the contents of the tree with these (id, location) pairs
+void Kd_tree::build(vector<pair<int, Point>> points_)
+{
+	points.swap(points_);
+	build_range(0, int(points.size()), true);
+}
+
+// put the median point of the range in the middle, the lower points before it
+// and the higher ones after it, then do the same for each half on the other axis
+void Kd_tree::build_range(int begin, int end, bool split_x)
+{
+	if (end - begin <= 1)
+		return;
+	int middle = begin + (end - begin) / 2;
+	nth_element(points.begin() + begin, points.begin() + middle, points.begin() + end,
+		[split_x](const pair<int, Point>& lhs, const pair<int, Point>& rhs) {
+			return split_x ? lhs.second.x < rhs.second.x : lhs.second.y < rhs.second.y;
+		});
+	build_range(begin, middle, !split_x);
+	build_range(middle + 1, end, !split_x);
+}
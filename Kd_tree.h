@@ -0,0 +1,87 @@
+#ifndef KD_TREE_H
+#define KD_TREE_H
+/*
+Kd_tree is a static 2-d tree over a set of points, each tagged with an integer ID
+(Model uses Entity_store IDs). It is built all at once from the full set of
+points and cannot be changed afterwards; to add a point, build it again.
+This suits the Structures, which never move and are only added by the build command.
+
+The tree is stored in a single vector: the subtree for the range [begin, end)
+has its splitting point at the middle of the range, with the points on the low
+side of the split before it and the points on the high side after it.
+The levels alternate splitting on x and y.
+*/
+#include "Geometry.h"
+
+#include <cmath>
+#include <utility>
+#include <vector>
+
+class Kd_tree {
+public:
+	// returned by nearest if the tree is empty
+	static const int no_id_c = -1;
+
+	// replace the contents of the tree with these (id, location) pairs
+	void build(std::vector<std::pair<int, Point>> points_);
+
+	bool empty() const
+		{return points.empty();}
+
+	// return the id closest to location, or no_id_c if the tree is empty.
+	// If several are equally close, the one that comes first according to comes_before(lhs, rhs) wins.
+	template<typename Ordering>
+	int nearest(Point location, Ordering comes_before) const;
+
+private:
+	std::vector<std::pair<int, Point>> points;
+
+	void build_range(int begin, int end, bool split_x);
+
+	template<typename Ordering>
+	void search(int begin, int end, bool split_x, Point location, Ordering& comes_before,
+		int& best, double& best_distance) const;
+};
+
+template<typename Ordering>
+int Kd_tree::nearest(Point location, Ordering comes_before) const
+{
+	int best = no_id_c;
+	double best_distance = 0.;
+	search(0, int(points.size()), true, location, comes_before, best, best_distance);
+	return best;
+}
+
+// Search the near side of the split first. The far side can only hold something as
+// close as the best so far if the splitting line itself is that close.
+template<typename Ordering>
+void Kd_tree::search(int begin, int end, bool split_x, Point location, Ordering& comes_before,
+	int& best, double& best_distance) const
+{
+	// allow for rounding in the distance calculations
+	const double slack_c = 1e-9;
+	if (begin >= end)
+		return;
+	int middle = begin + (end - begin) / 2;
+	const std::pair<int, Point>& split = points[middle];
+
+	double distance = cartesian_distance(location, split.second);
+	if (best == no_id_c || distance < best_distance ||
+		(distance == best_distance && comes_before(split.first, best))) {
+		best = split.first;
+		best_distance = distance;
+	}
+
+	double offset = split_x ? location.x - split.second.x : location.y - split.second.y;
+	if (offset < 0.) {
+		search(begin, middle, !split_x, location, comes_before, best, best_distance);
+		if (std::fabs(offset) * (1. - slack_c) <= best_distance)
+			search(middle + 1, end, !split_x, location, comes_before, best, best_distance);
+	} else {
+		search(middle + 1, end, !split_x, location, comes_before, best, best_distance);
+		if (std::fabs(offset) * (1. - slack_c) <= best_distance)
+			search(begin, middle, !split_x, location, comes_before, best, best_distance);
+	}
+}
+
+#endif
@@ -0,0 +1,122 @@
+#include "Kinematics.h"
+
+#include <cmath>
+#include <cstring>
+
+#if defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
+using namespace std;
+
+// start using slot for an object in this state
+void Kinematics::add(int slot, const Kinematic_state& state)
+{
+	if (slot >= int(x.size())) {
+		size_t size = slot + 1;
+		for (vector<double>* array : {&x, &y, &delta_x, &delta_y, &destination_x, &destination_y, &speed, &next_x, &next_y})
+			array->resize(size, 0.);
+		moving.resize(size, false);
+		arrives.resize(size, false);
+		stepped.resize(size, false);
+	}
+	set(slot, state);
+}
+
+// stop using slot; it is left not moving, so that step_all has nothing to do for it
+void Kinematics::remove(int slot)
+{
+	set(slot, Kinematic_state{false, Point(), 0., Point(), Cartesian_vector()});
+}
+
+Kinematic_state Kinematics::get(int slot) const
+{
+	return Kinematic_state{moving[slot] != 0, Point(x[slot], y[slot]), speed[slot],
+		Point(destination_x[slot], destination_y[slot]), Cartesian_vector(delta_x[slot], delta_y[slot])};
+}
+
+void Kinematics::set(int slot, const Kinematic_state& state)
+{
+	moving[slot] = state.moving;
+	x[slot] = state.location.x;
+	y[slot] = state.location.y;
+	speed[slot] = state.speed;
+	destination_x[slot] = state.destination.x;
+	destination_y[slot] = state.destination.y;
+	delta_x[slot] = state.delta.delta_x;
+	delta_y[slot] = state.delta.delta_y;
+	stepped[slot] = false;
+}
+
+// For every slot, the same calculation as Moving_object::update_location:
+// the object arrives if the distance left is no more than delta in both x and y,
+// in which case its next location is the destination, otherwise it's location + delta.
+// Every slot is calculated, moving or not, since that is cheaper than checking;
+// only the moving ones are marked as stepped.
+void Kinematics::step_all()
+{
+	int n = int(x.size());
+	int i = 0;
+#if defined(__AVX2__)
+	const __m256d sign_mask = _mm256_set1_pd(-0.);
+	for (; i + 4 <= n; i += 4) {
+		__m256d loc_x = _mm256_loadu_pd(&x[i]), loc_y = _mm256_loadu_pd(&y[i]);
+		__m256d dest_x = _mm256_loadu_pd(&destination_x[i]), dest_y = _mm256_loadu_pd(&destination_y[i]);
+		__m256d d_x = _mm256_loadu_pd(&delta_x[i]), d_y = _mm256_loadu_pd(&delta_y[i]);
+		__m256d left_x = _mm256_andnot_pd(sign_mask, _mm256_sub_pd(dest_x, loc_x));
+		__m256d left_y = _mm256_andnot_pd(sign_mask, _mm256_sub_pd(dest_y, loc_y));
+		__m256d arrive = _mm256_and_pd(
+			_mm256_cmp_pd(left_x, _mm256_andnot_pd(sign_mask, d_x), _CMP_LE_OQ),
+			_mm256_cmp_pd(left_y, _mm256_andnot_pd(sign_mask, d_y), _CMP_LE_OQ));
+		_mm256_storeu_pd(&next_x[i], _mm256_blendv_pd(_mm256_add_pd(loc_x, d_x), dest_x, arrive));
+		_mm256_storeu_pd(&next_y[i], _mm256_blendv_pd(_mm256_add_pd(loc_y, d_y), dest_y, arrive));
+		int mask = _mm256_movemask_pd(arrive);
+		for (int lane = 0; lane < 4; ++lane)
+			arrives[i + lane] = (mask >> lane) & 1;
+	}
+#elif defined(__SSE2__)
+	const __m128d sign_mask = _mm_set1_pd(-0.);
+	for (; i + 2 <= n; i += 2) {
+		__m128d loc_x = _mm_loadu_pd(&x[i]), loc_y = _mm_loadu_pd(&y[i]);
+		__m128d dest_x = _mm_loadu_pd(&destination_x[i]), dest_y = _mm_loadu_pd(&destination_y[i]);
+		__m128d d_x = _mm_loadu_pd(&delta_x[i]), d_y = _mm_loadu_pd(&delta_y[i]);
+		__m128d left_x = _mm_andnot_pd(sign_mask, _mm_sub_pd(dest_x, loc_x));
+		__m128d left_y = _mm_andnot_pd(sign_mask, _mm_sub_pd(dest_y, loc_y));
+		__m128d arrive = _mm_and_pd(
+			_mm_cmple_pd(left_x, _mm_andnot_pd(sign_mask, d_x)),
+			_mm_cmple_pd(left_y, _mm_andnot_pd(sign_mask, d_y)));
+		// no blend in SSE2, so pick with the mask
+		_mm_storeu_pd(&next_x[i], _mm_or_pd(_mm_and_pd(arrive, dest_x), _mm_andnot_pd(arrive, _mm_add_pd(loc_x, d_x))));
+		_mm_storeu_pd(&next_y[i], _mm_or_pd(_mm_and_pd(arrive, dest_y), _mm_andnot_pd(arrive, _mm_add_pd(loc_y, d_y))));
+		int mask = _mm_movemask_pd(arrive);
+		arrives[i] = mask & 1;
+		arrives[i + 1] = (mask >> 1) & 1;
+	}
+#endif
+	// whatever is left over, or everything if there's no SIMD
+	for (; i < n; ++i) {
+		bool arrive = fabs(destination_x[i] - x[i]) <= fabs(delta_x[i]) &&
+			fabs(destination_y[i] - y[i]) <= fabs(delta_y[i]);
+		next_x[i] = arrive ? destination_x[i] : x[i] + delta_x[i];
+		next_y[i] = arrive ? destination_y[i] : y[i] + delta_y[i];
+		arrives[i] = arrive;
+	}
+	if (n)
+		memcpy(stepped.data(), moving.data(), n);
+}
+
+// make the precomputed step; arriving means stopping, just as in Moving_object
+bool Kinematics::take_step(int slot, bool& arrived)
+{
+	if (!stepped[slot])
+		return false;
+	stepped[slot] = false;
+	x[slot] = next_x[slot];
+	y[slot] = next_y[slot];
+	arrived = arrives[slot];
+	if (arrived) {
+		moving[slot] = false;
+		delta_x[slot] = delta_y[slot] = 0.;
+		destination_x[slot] = destination_y[slot] = 0.;
+	}
+	return true;
+}
@@ -0,0 +1,63 @@
+#ifndef KINEMATICS_H
+#define KINEMATICS_H
+/*
+Kinematics keeps the movement state of many Moving_objects in structure-of-arrays
+form: the x and y of the location, the delta, the destination, the speed, and
+the moving flag of every object each have a contiguous array of their own,
+indexed by a slot number (Model uses the Agents' entity IDs).
+A Moving_object that has been bound to a slot keeps its state there.
+
+Once per tick, step_all works out every moving object's next step in a single
+pass over the arrays, using SIMD instructions where it can (AVX2 if the compiler
+is allowed to use it, otherwise SSE2, otherwise plain scalar code). The steps
+are not applied right away, because other objects must see the moving objects
+where they are until it's their turn to move. When an object's turn comes,
+take_step applies its precomputed step, including the arrival test, which gives
+bit for bit the same result as Moving_object's own calculation - unless its
+state has been changed since step_all, in which case the object works out its
+step itself.
+*/
+#include "Geometry.h"
+
+#include <vector>
+
+// the movement state of one Moving_object
+struct Kinematic_state {
+	bool moving;			// true if the object is moving
+	Point location;			// current location
+	double speed;			// distance moved per update
+	Point destination;		// destination to move to
+	Cartesian_vector delta;	// x, y increments per update
+};
+
+class Kinematics {
+public:
+	// start using slot for an object in this state
+	void add(int slot, const Kinematic_state& state);
+	// stop using slot
+	void remove(int slot);
+
+	Kinematic_state get(int slot) const;
+	// change the state; a step precomputed for the slot is then discarded
+	void set(int slot, const Kinematic_state& state);
+	bool is_moving(int slot) const
+		{return moving[slot];}
+	Point get_location(int slot) const
+		{return Point(x[slot], y[slot]);}
+
+	// work out the next step of every moving object
+	void step_all();
+	// if a step was precomputed for slot and its state hasn't changed since,
+	// make the step, set arrived to whether it reached the destination, and return true
+	bool take_step(int slot, bool& arrived);
+
+private:
+	std::vector<double> x, y, delta_x, delta_y, destination_x, destination_y, speed;
+	std::vector<char> moving;
+	// the precomputed steps
+	std::vector<double> next_x, next_y;
+	std::vector<char> arrives;
+	std::vector<char> stepped;		// true if the step for the slot is ready to take
+};
+
+#endif
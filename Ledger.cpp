@@ -0,0 +1,110 @@
+#include "Ledger.h"
+
+#include <algorithm>
+
+using namespace std;
+
+void Ledger::clear(int capacity)
+{
+	// keep the storage for the next tick
+	for (int id : structure_ids)
+		transfers[id].clear();
+	structure_ids.clear();
+	for (int id : entered_ids) {
+		is_entered[id] = false;
+		has_result[id] = false;
+	}
+	entered_ids.clear();
+	if (int(is_entered.size()) < capacity) {
+		is_entered.resize(capacity, false);
+		entered_structure_ids.resize(capacity);
+		has_result.resize(capacity, false);
+		results.resize(capacity);
+	}
+}
+
+bool Ledger::enter_withdrawal(int structure_id, int agent_id, double amount, bool standby)
+{
+	Transfer transfer {};
+	transfer.agent_id = agent_id;
+	transfer.standby = standby;
+	transfer.amount = amount;
+	return enter(structure_id, transfer);
+}
+
+bool Ledger::enter_deposit(int structure_id, int agent_id, double amount)
+{
+	Transfer transfer {};
+	transfer.agent_id = agent_id;
+	transfer.deposit = true;
+	transfer.amount = amount;
+	return enter(structure_id, transfer);
+}
+
+bool Ledger::enter(int structure_id, const Transfer& transfer)
+{
+	if (is_entered[transfer.agent_id])
+		return false;
+	is_entered[transfer.agent_id] = true;
+	entered_structure_ids[transfer.agent_id] = structure_id;
+	entered_ids.push_back(transfer.agent_id);
+	vector<Transfer>& entered = transfers[structure_id];
+	if (entered.empty())
+		structure_ids.push_back(structure_id);
+	entered.push_back(transfer);
+	return true;
+}
+
+void Ledger::sort(const function<int (int)>& rank_of)
+{
+	for (int structure_id : structure_ids) {
+		int structure_rank = rank_of(structure_id);
+		vector<Transfer>& entered = transfers[structure_id];
+		for (Transfer& transfer : entered) {
+			transfer.rank = rank_of(transfer.agent_id);
+			transfer.after_structure = transfer.rank > structure_rank;
+		}
+		std::sort(entered.begin(), entered.end(),
+			[](const Transfer& lhs, const Transfer& rhs) {return lhs.rank < rhs.rank;});
+	}
+}
+
+void Ledger::post_results()
+{
+	for (int structure_id : structure_ids)
+		post_results(structure_id, -1);
+}
+
+void Ledger::post_results(int structure_id, int rank)
+{
+	for (const Transfer& transfer : transfers.at(structure_id)) {
+		if (transfer.rank <= rank)
+			continue;
+		has_result[transfer.agent_id] = transfer.made;
+		results[transfer.agent_id] = transfer;
+	}
+}
+
+int Ledger::cancel(int agent_id)
+{
+	if (agent_id >= int(is_entered.size()) || !is_entered[agent_id])
+		return -1;
+	has_result[agent_id] = false;
+	int structure_id = entered_structure_ids[agent_id];
+	vector<Transfer>& entered = transfers.at(structure_id);
+	auto itr = find_if(entered.begin(), entered.end(),
+		[agent_id](const Transfer& transfer) {return transfer.agent_id == agent_id;});
+	if (itr == entered.end())
+		return -1;
+	entered.erase(itr);
+	return structure_id;
+}
+
+bool Ledger::take_result(int agent_id, Transfer& transfer)
+{
+	if (agent_id >= int(has_result.size()) || !has_result[agent_id])
+		return false;
+	has_result[agent_id] = false;
+	transfer = results[agent_id];
+	return true;
+}
@@ -0,0 +1,80 @@
+#ifndef LEDGER_H
+#define LEDGER_H
+/*
+A Ledger holds the transfers of food between Agents and Structures for one tick
+of a parallel update. Rather than each Peasant withdrawing or depositing at its
+turn, every Agent that will make a transfer this tick enters it in the Ledger
+before the objects are visited; each Structure then settles all of its own
+transfers in one batch, alphabetically by Agent, with the same outcome as if they
+had been made one at a time at each Agent's turn (see Structure::settle); and each
+Agent takes its result when its turn comes. A Structure touches nothing but itself
+while settling, so different Structures can settle at once, on different threads.
+
+An Agent waiting at a Structure enters a standby withdrawal, which is made only if
+a deposit earlier in the tick wakes it up, as it would then withdraw at its turn.
+An Agent that is killed before its turn makes no transfer after all: its transfer
+is cancelled, and the Structure settles the rest again.
+*/
+#include <functional>
+#include <unordered_map>
+#include <vector>
+
+// one Agent's transfer with a Structure
+struct Transfer {
+	int agent_id;
+	bool deposit;			// a deposit, or else a withdrawal
+	bool standby;			// a waiting Agent's withdrawal, made only if it's woken up first
+	double amount;			// the amount deposited, or asked for
+	// filled in by sort
+	int rank;				// the Agent's place in alphabetical order
+	bool after_structure;	// the Agent's turn comes after the Structure's
+	// filled in by settling
+	bool made;
+	double result;			// the amount withdrawn
+	bool wakes_waiters;		// a deposit that wakes up the waiting Agents
+};
+
+class Ledger {
+public:
+	// forget the last tick's transfers and results; capacity is one more than the largest Agent ID
+	void clear(int capacity);
+
+	// Enter a transfer with the Structure with this ID. An Agent has at most one
+	// transfer a tick; returns false, entering nothing, if it already has one.
+	bool enter_withdrawal(int structure_id, int agent_id, double amount, bool standby);
+	bool enter_deposit(int structure_id, int agent_id, double amount);
+
+	// the IDs of the Structures that have transfers, in the order they were first entered
+	const std::vector<int>& get_structure_ids() const
+		{return structure_ids;}
+	// the Structure's transfers; once sorted, alphabetically by Agent
+	std::vector<Transfer>& get_transfers(int structure_id)
+		{return transfers.at(structure_id);}
+	// put each Structure's transfers in order, given the rank of each object by ID
+	void sort(const std::function<int (int)>& rank_of);
+
+	// once the transfers are settled, make the results of those made available by Agent ID
+	void post_results();
+	// once the Structure with this ID has settled again, make the results of the transfers
+	// of the Agents that come after rank available
+	void post_results(int structure_id, int rank);
+	// take the transfer of the Agent with this ID out, and return the ID of its Structure,
+	// or -1 if it has none; the Agent enters nothing more this tick
+	int cancel(int agent_id);
+	// if the Agent with this ID had a transfer made, copy it into transfer, forget it, and return true
+	bool take_result(int agent_id, Transfer& transfer);
+
+private:
+	std::unordered_map<int, std::vector<Transfer>> transfers;
+	std::vector<int> structure_ids;
+	// by Agent ID
+	std::vector<char> is_entered;
+	std::vector<int> entered_structure_ids;
+	std::vector<char> has_result;
+	std::vector<Transfer> results;
+	std::vector<int> entered_ids;
+
+	bool enter(int structure_id, const Transfer& transfer);
+};
+
+#endif
@@ -2,23 +2,35 @@
 
 #include "Agent.h"
 #include "Agent_factory.h"
+#include "Checkpoint.h"
+#include "Event_stream.h"
 #include "Geometry.h"
+#include "Output.h"
 #include "Sim_object.h"
 #include "Structure.h"
 #include "Structure_factory.h"
+#include "Thread_pool.h"
 #include "Utility.h"
 #include "View.h"
 
 #include <algorithm>
 #include <iostream>
+#include <sstream>
+#include <unordered_map>
+#include <vector>
 using namespace std;
 
 // error messages
 const char* const no_structure {"Structure not found!"};
 const char* const no_agent {"Agent not found!"};
 const char* const no_view {"No view of that name available!"};
+const char* const corrupt_checkpoint {"Checkpoint file is corrupt!"};
+const char* const no_profiling {"Profiling is not compiled in!"};
 
-// should be one of the only uses of a "raw" pointer in the program
+// side of a Spatial_grid cell; a bit bigger than the longest attack range
+static const double agent_grid_cell_size_c {10.};
+
+// the default model, used by the plain Controller
 Model& Model::get_Model()
 {
 	static Model model;
@@ -29,19 +41,22 @@ Model& Model::get_Model()
 // either the identical name, or identical in first two characters counts as in-use
 bool Model::is_name_in_use(const string& name) const
 {
-	return sim_objs.find(name) != sim_objs.end();
+	return entities.contains(name);
 }
 
 // is there a structure with this name?
 bool Model::is_structure_present(const string& name) const
 {
-	return structure_objs.find(name) != structure_objs.end();
+	return entities.contains(name, Entity_store::Kind::STRUCTURE);
 }
 // add a new structure; assumes none with the same name
 void Model::add_structure(shared_ptr<Structure> new_structure)
 {
-	sim_objs.insert(make_pair(new_structure->get_name(), new_structure));
-	structure_objs.insert(make_pair(new_structure->get_name(), new_structure));
+	if (deferring_mutations) {
+		mutations.queue_insertion(new_structure, Entity_store::Kind::STRUCTURE);
+		return;
+	}
+	register_object(new_structure, Entity_store::Kind::STRUCTURE);
 	new_structure->broadcast_current_state();
 }
 
@@ -49,56 +64,603 @@ void Model::add_structure(shared_ptr<Structure> new_structure)
 // will throw Error("Structure not found!") if no structure of that name
 shared_ptr<Structure> Model::get_structure_ptr(const string& name) const
 {
-	auto structure_itr = structure_objs.find(name);
-	if (structure_itr == structure_objs.end())
+	if (!entities.contains(name, Entity_store::Kind::STRUCTURE))
 		throw Error(no_structure);
 		
-	return structure_itr->second;
+	return entities.get_structure(entities.find(name));
 }
 
 // is there an agent with this name?
 bool Model::is_agent_present(const string& name) const
 {
-	return agent_objs.find(name) != agent_objs.end();
+	return entities.contains(name, Entity_store::Kind::AGENT);
 }
 // add a new agent; assumes none with the same name
 void Model::add_agent(shared_ptr<Agent> new_agent)
 {
-	sim_objs.insert( make_pair(new_agent->get_name(), new_agent));
-	agent_objs.insert( make_pair(new_agent->get_name(), new_agent));
+	if (deferring_mutations) {
+		mutations.queue_insertion(new_agent, Entity_store::Kind::AGENT);
+		return;
+	}
+	register_object(new_agent, Entity_store::Kind::AGENT);
 	new_agent->broadcast_current_state();
 }
 // will throw Error("Agent not found!") if no agent of that name
 shared_ptr<Agent> Model::get_agent_ptr(const string& name) const
 {
-	auto agent_itr = agent_objs.find(name);
-	if(agent_itr == agent_objs.end())
+	if(!entities.contains(name, Entity_store::Kind::AGENT))
 		throw Error(no_agent);
 	else
-		return agent_itr->second;
+		return entities.get_agent(entities.find(name));
 }
 
 // tell all objects to describe themselves to the console
 void Model::describe() const
 {
-	for(auto& i : sim_objs)
-		i.second->describe();
+	Output_scope scope(output);
+	for(int id : entities.get_ordered_ids())
+		entities.get(id)->describe();
 }
 // increment the time, and tell all objects to update themselves
 void Model::update()
 {
+	Output_scope scope(output);
 	// add one to the time
 	++time;
+	++totals.ticks;
+#ifdef PROFILING
+	profiler.record_tick();
+#endif
+	if (event_stream)
+		event_stream->set_tick(time);
+	// throw away what's printed if we've been told to keep quiet
+	unique_ptr<Output_suppressor> quiet;
+	if (!chatter)
+		quiet.reset(new Output_suppressor);
+	batching_notifications = true;
+	deferring_mutations = true;
+	try {
+		if (thread_pool)
+			update_parallel();
+		else
+			update_sequential();
+	} catch (...) {
+		// make the changes and let the views know what happened before the error
+		deferring_mutations = false;
+		apply_mutations();
+		batching_notifications = false;
+		deliver_notifications();
+		throw;
+	}
+	deferring_mutations = false;
+	drop_idle();
+	apply_mutations();
+	batching_notifications = false;
+	deliver_notifications();
+	output.flush();
+	// a stream that can't be written any more is closed
+	if (event_stream) {
+		try {
+			event_stream->flush();
+		} catch (...) {
+			event_stream.reset();
+			throw;
+		}
+	}
+}
+
+// update ticks times, skipping over whatever can be when there's no chatter to print
+void Model::run(int ticks)
+{
+	Output_scope scope(output);
+	while (ticks > 0) {
+		if (!is_chatty())
+			ticks -= fast_forward(ticks);
+		if (ticks > 0) {
+			update();
+			--ticks;
+		}
+	}
+}
+
+// Skip over as many of the next ticks as every active object can, up to ticks, and
+// return how many. The objects are fast-forwarded one at a time; none of them looks
+// at the others meanwhile, so it doesn't matter that they aren't in step.
+int Model::fast_forward(int ticks)
+{
+	int skipped = ticks;
+	for (int id : active_ids) {
+		skipped = entities.get(id)->get_skippable_ticks(skipped);
+		if (skipped == 0)
+			return 0;
+	}
+	int start = time;
+	time = start + skipped;
+	totals.ticks += skipped;
+#ifdef PROFILING
+	profiler.record_tick(skipped);
+#endif
+	// there's no chatter, so what's printed is thrown away, but is printed all the same
+	Output_suppressor quiet;
+	batching_notifications = true;
+	// the Agents that arrived, by the tick they arrived in, and alphabetically
+	vector<pair<int, int>> arrivals;
+	for (int id : active_ids) {
+		Sim_object& object = *entities.get(id);
+		int arrival = object.fast_forward(skipped);
+		if (entities.get_kind(id) != Entity_store::Kind::AGENT)
+			continue;
+		if (arrival)
+			arrivals.push_back(make_pair(arrival, id));
+		object.broadcast_current_state();
+	}
+	stable_sort(arrivals.begin(), arrivals.end(),
+		[](const pair<int, int>& lhs, const pair<int, int>& rhs) {return lhs.first < rhs.first;});
+	for (const pair<int, int>& arrival : arrivals) {
+		time = start + arrival.first;
+		entities.get_agent(arrival.second)->announce_arrival(Output::chatter());
+		record_arrival();
+	}
+	time = start + skipped;
+	drop_idle();
+	batching_notifications = false;
+	deliver_notifications();
+	return skipped;
+}
+
+// tell the model that the object with this ID has something to do.
+// Keep active_ids in alphabetical order; if we're walking it, keep the cursor
+// on the object being updated, so that a newcomer is visited this tick only if it comes later.
+void Model::activate(int id)
+{
+	// an object that isn't in a model yet becomes active when it is added
+	if (id < 0 || entities.get(id) == nullptr)
+		return;
+	if (id >= int(is_in_active_set.size()))
+		is_in_active_set.resize(entities.get_capacity(), false);
+	if (is_in_active_set[id])
+		return;
+	is_in_active_set[id] = true;
+	// compare names rather than ranks, which would be recomputed after every insertion
+	auto itr = lower_bound(active_ids.begin(), active_ids.end(), id,
+		[this](int lhs, int rhs) {return entities.comes_before(lhs, rhs);});
+	size_t position = itr - active_ids.begin();
+	active_ids.insert(itr, id);
+	if (walking_active && position <= active_cursor)
+		++active_cursor;
+}
+
+// while walking active_ids, an object's turn has come if it's no later alphabetically
+// than the object being updated, whether or not it's in the active set itself
+int Model::get_time_updated(int id) const
+{
+	if (!walking_active)
+		return time;
+	return entities.get_rank(id) <= entities.get_rank(active_ids[active_cursor]) ? time : time - 1;
+}
+
+void Model::set_chatter(bool chatter_)
+{
+	chatter = chatter_;
+	if (chatter) {
+		for (int id : entities.get_ids(Entity_store::Kind::AGENT))
+			activate(id);
+	}
+}
+
+// the objects are named in the stream in alphabetical order; the Agents that have
+// been left asleep because there was no chatter have something to record again.
+// The header is written out at once, so that a bad fd is caught here.
+void Model::open_event_stream(int fd)
+{
+	event_stream.reset(new Event_stream(fd));
+	event_stream->set_tick(time);
+	for (int id : entities.get_ordered_ids()) {
+		const Sim_object& object = *entities.get(id);
+		event_stream->record_named(object.get_symbol(), object.get_type_name(), object.get_name());
+	}
+	try {
+		event_stream->flush();
+	} catch (...) {
+		event_stream.reset();
+		throw;
+	}
+	for (int id : entities.get_ids(Entity_store::Kind::AGENT))
+		activate(id);
+}
+
+void Model::close_event_stream()
+{
+	unique_ptr<Event_stream> closing(move(event_stream));
+	if (closing)
+		closing->flush();
+}
+
+// turning the reports on means the Farms have to be updated again
+void Model::set_production_reports(bool production_reports_)
+{
+	production_reports = production_reports_;
+	if (production_reports) {
+		for (int id : entities.get_ids(Entity_store::Kind::STRUCTURE))
+			activate(id);
+	}
+}
+
+void Model::deactivate(int id)
+{
+	if (id >= int(is_in_active_set.size()) || !is_in_active_set[id])
+		return;
+	is_in_active_set[id] = false;
+	active_ids.erase(find(active_ids.begin(), active_ids.end(), id));
+}
+
+// drop the objects that have nothing left to do, or are dead, from the active set
+void Model::drop_idle()
+{
+	auto keep_end = remove_if(active_ids.begin(), active_ids.end(), [this](int id) {
+		if (is_active(id) && entities.get(id)->has_pending_work())
+			return false;
+		is_in_active_set[id] = false;
+		return true;
+	});
+	active_ids.erase(keep_end, active_ids.end());
+}
+
+// make the changes held back during the tick, in the order they were asked for
+void Model::apply_mutations()
+{
+	for (Mutation_buffer::Mutation& mutation : mutations.take()) {
+		if (mutation.insertion) {
+			register_object(mutation.object, mutation.kind);
+			mutation.object->broadcast_current_state();
+		} else {
+			erase_agent(mutation.object->get_id());
+		}
+	}
+}
+
+// is the object with this ID still taking part: live, and if an agent, alive?
+bool Model::is_active(int id) const
+{
+	if (!entities.is_live(id))
+		return false;
+	return entities.get_kind(id) == Entity_store::Kind::STRUCTURE || entities.get_agent(id)->is_alive();
+}
+
+void Model::update_sequential()
+{
 	// update all the Sim_objects alphabetically
-	for(auto& i : sim_objs)
-		i.second->update();
+	// Agents may die as we go; they stay put until the tick is over, but are skipped
+	{
+		PROFILE_PHASE(*this, MOVEMENT);
+		kinematics.step_all();
+	}
+	// only the objects in the active set need updating; more may join as we go
+	Entity_store::Walk walk(entities);
+	walking_active = true;
+	try {
+		for (active_cursor = 0; active_cursor < active_ids.size(); ++active_cursor) {
+			int id = active_ids[active_cursor];
+			if (!is_active(id))
+				continue;
+			Sim_object& object = *entities.get(id);
+			PROFILE_UPDATE(*this, object);
+			object.update();
+		}
+	} catch (...) {
+		walking_active = false;
+		throw;
+	}
+	walking_active = false;
+}
+
+void Model::update_parallel()
+{
+	// forget last tick's movements, which may have been left behind by an error
+	for (int id : moving_ids) {
+		if (id < int(movements.size()))
+			movements[id] = char(Agent::Movement_e::NONE);
+	}
+	// only the active agents can move
+	moving_ids.clear();
+	for (int id : active_ids) {
+		if (entities.get_kind(id) == Entity_store::Kind::AGENT && is_active(id))
+			moving_ids.push_back(id);
+	}
+	const vector<int>& agent_ids = moving_ids;
+	int capacity = entities.get_capacity();
+	frozen_locations.resize(capacity);
+	movements.resize(capacity, char(Agent::Movement_e::NONE));
+	movement_messages.resize(capacity);
+	for (int id : agent_ids)
+		frozen_locations[id] = entities.get(id)->get_location();
+
+	// first step every agent's movement in parallel, holding on to their messages,
+	// unless they wouldn't be printed anyway
+	{
+		PROFILE_PHASE(*this, MOVEMENT);
+		kinematics.step_all();
+		bool printing = output.is_printed(Output::Level_e::CHATTER);
+		thread_pool->parallel_for(int(agent_ids.size()), [this, &agent_ids, printing](int begin, int end) {
+			ostringstream os;
+			os.copyfmt(output.get_destination());
+			if (!printing)
+				os.setstate(ios::badbit);
+			for (int i = begin; i < end; ++i) {
+				int id = agent_ids[i];
+				movements[id] = char(static_cast<Agent&>(*entities.get(id)).update_movement(os));
+				movement_messages[id] = os.str();
+				os.str("");
+			}
+		});
+	}
+
+	// then make the tick's transfers of food, and do everything else alphabetically,
+	// seeing the agents where they were
+	in_parallel_update = true;
+	try {
+		settle_transfers();
+		visit_after_movement();
+	} catch (...) {
+		in_parallel_update = false;
+		throw;
+	}
+	in_parallel_update = false;
+	for (int id : ledger.get_structure_ids())
+		entities.get_structure(id)->notify_amount();
+
+	// commit the new locations
+	for (int id : moving_ids) {
+		if (Agent::Movement_e(movements[id]) != Agent::Movement_e::NONE)
+			agent_grid.move(id, entities.get(id)->get_location());
+		movements[id] = char(Agent::Movement_e::NONE);
+	}
+	moving_ids.clear();
+}
+
+// Have the agents enter the transfers they'll make at their turns, and each
+// structure settle its own, in parallel
+void Model::settle_transfers()
+{
+	PROFILE_PHASE(*this, PEASANT_WORK);
+	ledger.clear(entities.get_capacity());
+	for (int id : moving_ids)
+		entities.get_agent(id)->plan_transfer(ledger);
+	// a waiting agent can only be woken up by a deposit
+	const vector<int>& structure_ids = ledger.get_structure_ids();
+	int structure_count = int(structure_ids.size());
+	for (int i = 0; i < structure_count; ++i) {
+		vector<Transfer>& transfers = ledger.get_transfers(structure_ids[i]);
+		if (any_of(transfers.begin(), transfers.end(), [](const Transfer& transfer) {return transfer.deposit;}))
+			entities.get_structure(structure_ids[i])->plan_waiters(ledger);
+	}
+	if (structure_ids.empty())
+		return;
+	ledger.sort([this](int id) {return entities.get_rank(id);});
+
+	int settle_time = time;
+	thread_pool->parallel_for(int(structure_ids.size()), [this, &structure_ids, settle_time](int begin, int end) {
+		for (int i = begin; i < end; ++i) {
+			int id = structure_ids[i];
+			entities.get_structure(id)->settle(ledger.get_transfers(id), settle_time);
+		}
+	});
+	ledger.post_results();
+}
+
+// an agent killed before its turn makes no transfer, so its structure settles the rest again
+void Model::cancel_transfer(int id)
+{
+	int rank = entities.get_rank(id);
+	if (rank <= entities.get_rank(active_ids[active_cursor]))
+		return;
+	int structure_id = ledger.cancel(id);
+	if (structure_id < 0)
+		return;
+	entities.get_structure(structure_id)->resettle(ledger.get_transfers(structure_id), time);
+	ledger.post_results(structure_id, rank);
+}
+
+bool Model::take_transfer_result(int id, Transfer& transfer)
+{
+	return in_parallel_update && ledger.take_result(id, transfer);
+}
+
+// the second phase of a parallel update: print each agent's held-back messages
+// and do everything else the objects do, alphabetically
+void Model::visit_after_movement()
+{
+	Entity_store::Walk walk(entities);
+	walking_active = true;
+	try {
+		for (active_cursor = 0; active_cursor < active_ids.size(); ++active_cursor) {
+			int id = active_ids[active_cursor];
+			Sim_object& object = *entities.get(id);
+			PROFILE_UPDATE(*this, object);
+			if (entities.get_kind(id) == Entity_store::Kind::STRUCTURE) {
+				object.update();
+				continue;
+			}
+			// the agent moved even if it has been killed since
+			Agent::Movement_e movement = Agent::Movement_e(movements[id]);
+			Agent& agent = static_cast<Agent&>(object);
+			Output::chatter() << movement_messages[id];
+			movement_messages[id].clear();
+			agent.record_movement(movement);
+			if (movement == Agent::Movement_e::ARRIVAL)
+				record_arrival();
+			if (!agent.is_alive())
+				continue;
+			if (movement != Agent::Movement_e::NONE)
+				agent.broadcast_current_state();
+			agent.update_behavior();
+		}
+	} catch (...) {
+		walking_active = false;
+		throw;
+	}
+	walking_active = false;
+}
+
+// the objects of a checkpoint, numbered by record
+class Checkpoint_objects : public Checkpoint_links {
+public:
+	void add(shared_ptr<Sim_object> object)
+	{
+		records.insert(make_pair(object.get(), int32_t(objects.size())));
+		objects.push_back(object);
+	}
+	int32_t record_of(const Sim_object* object) const override
+	{
+		auto itr = records.find(object);
+		return itr == records.end() ? checkpoint_no_link_c : itr->second;
+	}
+	shared_ptr<Sim_object> object_at(int32_t record) const override
+	{
+		if (record == checkpoint_no_link_c)
+			return nullptr;
+		if (record < 0 || record >= int32_t(objects.size()))
+			throw Error(corrupt_checkpoint);
+		return objects[record];
+	}
+private:
+	vector<shared_ptr<Sim_object>> objects;
+	unordered_map<const Sim_object*, int32_t> records;
+};
+
+// write the whole world to a checkpoint file, one record per object in alphabetical order
+void Model::save_checkpoint(const string& filename) const
+{
+	Checkpoint_objects links;
+	for (int id : entities.get_ordered_ids())
+		links.add(entities.get(id));
+
+	Checkpoint_writer writer(time);
+	for (int id : entities.get_ordered_ids()) {
+		const Sim_object& object = *entities.get(id);
+		Checkpoint_record& record = writer.add_record(object.get_name(), object.get_type_name());
+		record.kind = entities.get_kind(id) == Entity_store::Kind::AGENT ? checkpoint_agent_c : checkpoint_structure_c;
+		record.x = object.get_location().x;
+		record.y = object.get_location().y;
+		object.save_state(record, links);
+	}
+	writer.write(filename);
+}
+
+// replace the whole world with the one saved in a checkpoint file
+void Model::load_checkpoint(const string& filename)
+{
+	// build the new world on the side, so that if anything is wrong the old one is untouched
+	Checkpoint_reader reader(filename);
+	Checkpoint_objects links;
+	unordered_map<string, int> names;
+	for (int i = 0; i < reader.get_record_count(); ++i) {
+		const Checkpoint_record& record = reader.get_record(i);
+		string name = reader.get_name(record);
+		if (name.empty() || !names.insert(make_pair(name, i)).second)
+			throw Error(corrupt_checkpoint);
+		Point location(record.x, record.y);
+		if (record.kind == checkpoint_agent_c)
+			links.add(create_agent(name, reader.get_type(record), location));
+		else
+			links.add(create_structure(name, reader.get_type(record), location));
+	}
+	for (int i = 0; i < reader.get_record_count(); ++i)
+		links.object_at(i)->restore_state(reader.get_record(i), links);
+
+	// out with the old world
+	for (int id : entities.get_ordered_ids())
+		notify_gone(entities.get(id)->get_symbol());
+	for (int id : entities.get_ids(Entity_store::Kind::AGENT))
+		entities.get_agent(id)->bind_kinematics(nullptr, 0);
+	entities.clear();
+	active_ids.clear();
+	is_in_active_set.clear();
+	agent_grid.clear();
+	structure_tree_stale = true;
+
+	// and in with the new
+	time = reader.get_time();
+	if (event_stream)
+		event_stream->set_tick(time);
+	for (int i = 0; i < reader.get_record_count(); ++i) {
+		const Checkpoint_record& record = reader.get_record(i);
+		register_object(links.object_at(i),
+			record.kind == checkpoint_agent_c ? Entity_store::Kind::AGENT : Entity_store::Kind::STRUCTURE);
+	}
+	for (int id : entities.get_ordered_ids())
+		entities.get(id)->broadcast_current_state();
+}
+
+// print where the ticks have spent their time
+void Model::describe_stats() const
+{
+	Output_scope scope(output);
+#ifdef PROFILING
+	profiler.describe(Output::events());
+#else
+	throw Error(no_profiling);
+#endif
+}
+
+void Model::clear_stats()
+{
+#ifdef PROFILING
+	profiler.clear();
+#else
+	throw Error(no_profiling);
+#endif
+}
+
+// number of threads update uses
+int Model::get_thread_count() const
+{
+	return thread_pool ? thread_pool->get_thread_count() : 1;
+}
+
+void Model::set_thread_count(int thread_count)
+{
+	if (thread_count <= 1)
+		thread_pool.reset();
+	else if (thread_count != get_thread_count())
+		thread_pool.reset(new Thread_pool(thread_count));
+}
+
+// where other objects should see the agent
+Point Model::get_observed_location(const Agent& agent) const
+{
+	// an agent that hasn't moved this tick is still where it was
+	if (in_parallel_update && Agent::Movement_e(movements[agent.get_id()]) != Agent::Movement_e::NONE)
+		return frozen_locations[agent.get_id()];
+	return agent.get_location();
 }
 
 void Model::remove_agent(shared_ptr<Agent> agent)
 {
-	// remove from sim objs and agents
-	sim_objs.erase(agent->get_name());
-	agent_objs.erase(agent->get_name());
+	if (deferring_mutations) {
+		mutations.queue_removal(agent, Entity_store::Kind::AGENT);
+		if (in_parallel_update && walking_active)
+			cancel_transfer(agent->get_id());
+		return;
+	}
+	erase_agent(agent->get_id());
+}
+
+// take the agent out of the entity store, the spatial grid and the kinematics
+void Model::erase_agent(int id)
+{
+	agent_grid.erase(id);
+	deactivate(id);
+	entities.get_agent(id)->bind_kinematics(nullptr, 0);
+	entities.erase(id);
+}
+
+// tell the model that the agent with this ID is now at location
+void Model::update_agent_location(int id, Point location)
+{
+	// during a parallel update the grid keeps the old locations until the end of the tick
+	if (!in_parallel_update && agent_grid.contains(id))
+		agent_grid.move(id, location);
 }
 
 /* View services */
@@ -107,8 +669,8 @@ void Model::remove_agent(shared_ptr<Agent> agent)
 void Model::attach(string view_name, shared_ptr<View> view)
 {
 	views.push_back(make_pair(view_name, view));
-	for(auto& i : sim_objs)
-		i.second->broadcast_current_state();
+	for(int id : entities.get_ordered_ids())
+		entities.get(id)->broadcast_current_state();
 }
 // Detach the View by discarding the supplied pointer from the container of Views
 // - no updates sent to it thereafter.
@@ -122,35 +684,75 @@ void Model::detach(string view_name)
 	}
 }
 // notify the views about an object's location
-void Model::notify_location(const string& name, Point location)
+void Model::notify_location(int symbol, Point location)
 {
+	PROFILE_PHASE(*this, VIEW_UPDATES);
+	if (batching_notifications) {
+		notifications.record_location(symbol, location);
+		return;
+	}
 	for(auto& i : views)
-		i.second->update_location(name, location);
+		i.second->update_location(symbol, location);
 }
 // notify views about an objects amounts
-void Model::notify_amount(const string& name, double amount)
+void Model::notify_amount(int symbol, double amount)
 {
+	PROFILE_PHASE(*this, VIEW_UPDATES);
+	if (batching_notifications) {
+		notifications.record_amount(symbol, amount);
+		return;
+	}
 	for(auto& i : views)
-		i.second->update_amount(name, amount);
+		i.second->update_amount(symbol, amount);
 }
 // notify the views about an objects health
-void Model::notify_health(const string& name, double health)
+void Model::notify_health(int symbol, double health)
 {
+	PROFILE_PHASE(*this, VIEW_UPDATES);
+	if (batching_notifications) {
+		notifications.record_health(symbol, health);
+		return;
+	}
 	for(auto & i : views)
-		i.second->update_health(name, health);
+		i.second->update_health(symbol, health);
 }
 
 // notify the views that an object is now gone
-void Model::notify_gone(const string& name)
+void Model::notify_gone(int symbol)
 {
+	PROFILE_PHASE(*this, VIEW_UPDATES);
+	if (batching_notifications) {
+		notifications.record_gone(symbol);
+		return;
+	}
+	for(auto& i : views)
+		i.second->update_remove(symbol);
+}
+
+// send the queued up changes to the views
+void Model::deliver_notifications()
+{
+	PROFILE_PHASE(*this, VIEW_UPDATES);
+	if (notifications.empty())
+		return;
 	for(auto& i : views)
-		i.second->update_remove(name);
+		notifications.deliver(*i.second);
+	notifications.clear();
 }
 // notify every view to draw itself
 void Model::draw_all_views()
 {
-	for(auto& i : views)
-		i.second->draw();
+	Output_scope scope(output);
+	// the Farms' production isn't sent to the Views as it happens
+	for (int id : entities.get_ids(Entity_store::Kind::STRUCTURE))
+		entities.get_structure(id)->catch_up();
+	PROFILE_PHASE(*this, VIEW_DRAWING);
+	for(auto& i : views) {
+		if (delta_drawing)
+			i.second->draw_changes();
+		else
+			i.second->draw();
+	}
 }
 // returns the view specified by view_name, otherwise throw an error
 shared_ptr<View> Model::get_view(const string& view_name)
@@ -162,46 +764,71 @@ shared_ptr<View> Model::get_view(const string& view_name)
 	throw Error(no_view);
 }
 
-// function object to compare distances between two Agents and the saved agent
-class CompSimObjDistance {
-public:
-	CompSimObjDistance(shared_ptr<Agent> current_agent_)
-	: current_agent(current_agent_)
-	{}
-
-	bool operator() (pair<string, shared_ptr<Sim_object> > lhs, pair<string, shared_ptr<Sim_object> > rhs)
-	{
-		if (current_agent == lhs.second) {
-			// don't want to attack ourselves
-			return false;
-		} else if (current_agent == rhs.second) {
-			return true;
-		}
-		// calculate the distance between the current location and two different points
-		double lhs_distance = cartesian_distance(current_agent->get_location(), lhs.second->get_location());
-		double rhs_distance = cartesian_distance(current_agent->get_location(), rhs.second->get_location());
-		return lhs_distance < rhs_distance;
-	}
-private:
-	shared_ptr<Agent> current_agent;
-};
-
-// returns a shared_ptr to the closest agent to location
+// returns a shared_ptr to the closest other agent, breaking ties alphabetically
 shared_ptr<Agent> Model::get_closest_agent(shared_ptr<Agent> current_agent)
 {
-	// in case of a tie, min_element will return the first of the two objects
-	// luckily, agent_objs and structure_objs are kept in alphabetical order
-	return min_element(agent_objs.begin(), agent_objs.end(), CompSimObjDistance(current_agent))->second;
+	PROFILE_PHASE(*this, CLOSEST_QUERIES);
+	const Entity_store& store = entities;
+	int current_id = current_agent->get_id();
+	int closest = agent_grid.nearest(get_observed_location(*current_agent),
+		[this, current_id](int id) {return id != current_id && is_active(id);},
+		[&store](int lhs, int rhs) {return store.get(lhs)->get_name() < store.get(rhs)->get_name();});
+	if (closest == Spatial_grid::no_id_c)
+		return current_agent;
+	return entities.get_agent(closest);
+}
+
+// returns all the agents no further than radius from center, in alphabetical order
+vector<shared_ptr<Agent>> Model::get_agents_within(Point center, double radius)
+{
+	PROFILE_PHASE(*this, CLOSEST_QUERIES);
+	vector<int> ids = agent_grid.within(center, radius);
+	ids.erase(remove_if(ids.begin(), ids.end(), [this](int id) {return !is_active(id);}), ids.end());
+	sort(ids.begin(), ids.end(), [this](int lhs, int rhs) {
+		return entities.get(lhs)->get_name() < entities.get(rhs)->get_name();
+	});
+	vector<shared_ptr<Agent>> agents;
+	for (int id : ids)
+		agents.push_back(entities.get_agent(id));
+	return agents;
 }
 
-// returns a shared_ptr to the closes structure to location
+// returns a shared_ptr to the closest structure, breaking ties alphabetically
 shared_ptr<Structure> Model::get_closest_structure(shared_ptr<Agent> current_agent)
 {
-	return min_element(structure_objs.begin(), structure_objs.end(), CompSimObjDistance(current_agent))->second;
+	PROFILE_PHASE(*this, CLOSEST_QUERIES);
+	if (structure_tree_stale) {
+		vector<pair<int, Point>> points;
+		for (int id : entities.get_ids(Entity_store::Kind::STRUCTURE))
+			points.push_back(make_pair(id, entities.get(id)->get_location()));
+		structure_tree.build(points);
+		structure_tree_stale = false;
+	}
+	const Entity_store& store = entities;
+	int closest = structure_tree.nearest(current_agent->get_location(),
+		[&store](int lhs, int rhs) {return store.get(lhs)->get_name() < store.get(rhs)->get_name();});
+	if (closest == Kd_tree::no_id_c)
+		return nullptr;
+	return entities.get_structure(closest);
 }
 
-Model::Model()
+Model::Model(bool populate)
+:
+time {0},
+chatter {true},
+production_reports {true},
+delta_drawing {false},
+agent_grid(agent_grid_cell_size_c),
+structure_tree_stale {true},
+in_parallel_update {false},
+walking_active {false},
+active_cursor {0},
+deferring_mutations {false},
+batching_notifications {false}
 {
+	if (!populate)
+		return;
+
 	insert_Structure(create_structure("Rivendale", "Farm", Point(10., 10.)));
 	insert_Structure(create_structure("Sunnybrook", "Farm", Point(0., 30.)));
 	insert_Structure(create_structure("Shire", "Town_Hall", Point(20., 20.)));
@@ -214,13 +841,38 @@ Model::Model()
 	insert_Agent(create_agent("Iriel", "Archer", Point(20., 38.)));
 }
 
+// defined here, where Thread_pool is complete;
+// the agents take their movement state back, in case they outlive us
+Model::~Model()
+{
+	for (int id : entities.get_ids(Entity_store::Kind::AGENT))
+		entities.get_agent(id)->bind_kinematics(nullptr, 0);
+}
+
 void Model::insert_Agent(shared_ptr<Agent> agent)
 {
-	sim_objs.insert(make_pair(agent->get_name(), agent));
-	agent_objs.insert(make_pair(agent->get_name(), agent));
+	register_object(agent, Entity_store::Kind::AGENT);
 }
 void Model::insert_Structure(shared_ptr<Structure> structure)
 {
-	sim_objs.insert(make_pair(structure->get_name(), structure));
-	structure_objs.insert(make_pair(structure->get_name(), structure));
+	register_object(structure, Entity_store::Kind::STRUCTURE);
+}
+
+// intern the object's name and add it to the entity store
+void Model::register_object(shared_ptr<Sim_object> object, Entity_store::Kind kind)
+{
+	object->set_model(this);
+	object->set_symbol(symbols.intern(object->get_name()));
+	symbols.set_type_name(object->get_symbol(), object->get_type_name());
+	object->set_id(entities.insert(object, kind));
+	if (event_stream)
+		event_stream->record_named(object->get_symbol(), object->get_type_name(), object->get_name());
+	if (kind == Entity_store::Kind::AGENT) {
+		static_cast<Agent&>(*object).bind_kinematics(&kinematics, object->get_id());
+		agent_grid.insert(object->get_id(), object->get_location());
+	}
+	else
+		structure_tree_stale = true;
+	// new objects start out active, and are dropped after their first update if they have nothing to do
+	activate(object->get_id());
 }
@@ -1,11 +1,12 @@
 #ifndef MODEL_H
 #define MODEL_H
 /*
-Model is made global through the use of the singleton pattern,
-notice how its constructor is declared private. The only way for users
-to get a hold of the model is to call the static method get_Model
-which will either create an instance of Model or return one that's already
-been made, through the magic of static memory
+Each Model is an independent world, and any number of them can be created,
+each to be run by its own Controller or on its own thread. Every Sim_object
+remembers the Model it was added to, and talks only to that one.
+There is also a default Model, kept in static memory, which the static method
+get_Model returns; it is the one the plain Controller uses. An object must be
+added to a Model before it uses it; none is assumed for it before then.
 Model is part of a simplified Model-View-Controller pattern.
 Model keeps track of the Sim_objects in our little world. It is the only
 component that knows how many Structures and Agents there are, but it does not
@@ -14,29 +15,125 @@ It has facilities for looking up objects by name, and removing Agents.  When
 created, it creates an initial group of Structures and Agents using the Structure_factory
 and Agent_factory.
 Finally, it keeps the system's time.
+The whole world, time included, can be saved to a checkpoint file and loaded back
+from one; see Checkpoint.h for the format.
 
 Controller tells Model what to do; Model in turn tells the objects what do, and
 when asked to do so by an object, tells all the Views whenever anything changes that might be relevant.
 Model also provides facilities for looking up objects given their name.
 
-Notice how only the Standard Library headers need to be included - reduced coupling!
+Model keeps its objects in an Entity_store, which gives every object an integer ID
+and keeps the IDs in alphabetical order, so the objects are still updated alphabetically.
+It also interns every object's name in a Symbol_table; objects and Views
+refer to each other by symbol, and the Views look names up only to print them.
+The Agents are also kept in a Spatial_grid, which Agents keep up to date as they
+move, so that finding the Agents near a point doesn't mean looking at all of them.
+Structures never move, so for them a static Kd_tree is built, and built again
+only when a new Structure has been added since the last time it was needed.
+The Agents' movement state is kept in a Kinematics, which works out all of their
+steps in one pass at the start of each tick; each Agent takes its step when its
+turn comes.
+
+Only the objects that have something to do are updated: Model keeps the IDs of
+those in an active set, in alphabetical order. Objects join the set when they are
+added, and tell Model (activate) when they get something new to do; at the end
+of each tick, those that have nothing left to do (has_pending_work) are dropped.
+An object that is activated during a tick, after its turn, is updated next tick;
+if before its turn, this tick, just as if every object were updated every tick.
+
+Normally the objects are updated one after another. Model can instead be told to
+use several threads. Only movement, and the settling of the food transfers, is
+then done in parallel; each tick is done in two phases. First every
+Agent's movement is stepped, in parallel on a Thread_pool; a step touches nothing
+but the Agent itself, and its messages are held back. Then the objects are visited
+alphabetically on one thread, printing the held-back messages and doing
+everything else they do. While they do, the other Agents are observed
+where they were at the start of the tick: get_observed_location and the
+closest-agent and range queries read a frozen copy of the locations, and the new
+locations are committed once the tick is over. Between the two phases, the food
+the Peasants will withdraw and deposit during the tick is entered in a Ledger,
+and each Structure settles its own transfers, in parallel; the Peasants take
+their results at their turns (take_transfer_result).
+Only the locations are frozen. The rest of each update still runs on the one
+thread, alphabetically, against the live state, just as in a sequential tick:
+the Warriors' attacks and the health they take, the Peasants' decisions, the
+Farms' production and the notifications to the Views. So an Agent hit or killed
+earlier in the tick is seen that way by those after it, and the food a Peasant
+can collect is what its Farm has when the Ledger is settled, not at the start of
+the tick. Freezing health and amounts as well is left for when those parts are
+moved onto the pool.
+
+Model also counts the arrivals, deaths and food deposits as they happen, so that
+the Controller can summarize a run of ticks, and can be told to keep quiet: with
+chatter turned off, whatever the objects print while updating is thrown away.
+Since nothing is printed then, run can skip ahead over whole stretches of ticks in
+which every active object reports (get_skippable_ticks) that it would do nothing but
+travel, or produce, without touching or looking at any other object: each object
+is fast-forwarded on its own, and the Agents that arrive during the stretch are
+announced and counted at the tick in which they arrived.
+
+Model can also keep an Event_stream, in which the objects record what happens as
+typed binary records, alongside or instead of the messages they print. While one
+is open, every tick is updated in full, as if chatter were on, so that nothing
+goes unrecorded.
+
+During a tick, objects aren't added to or removed from the containers; the changes
+go into a Mutation_buffer and are made once the tick is over. Until then, an Agent
+that has died stays where it was, and is skipped by the updates and the queries.
+Likewise, the notify functions don't call the Views directly; the changes go
+into a Notification_queue, which merges repeated changes to the same object,
+and are delivered to the Views in one batch when the tick is over.
+
+Model also keeps a Profiler of where the ticks spend their time, when profiling is compiled in.
+
+Each Model prints through an Output of its own (see Output.h), which it makes the
+current one while it updates, describes itself or draws its views; turning the
+chatter off, or the level up, in one world leaves the others alone.
+
+Notice how apart from Entity_store, Kd_tree, Ledger, Mutation_buffer, Notification_queue, Output,
+Profiler, Spatial_grid and Symbol_table only the Standard Library headers need to be included - reduced coupling!
 
 */
+#include "Entity_store.h"
+#include "Kd_tree.h"
+#include "Kinematics.h"
+#include "Ledger.h"
+#include "Mutation_buffer.h"
+#include "Notification_queue.h"
+#include "Output.h"
+#include "Profiler.h"
+#include "Spatial_grid.h"
+#include "Symbol_table.h"
+
 #include <list>
-#include <map>
 #include <memory>
 #include <string>
 #include <utility>
+#include <vector>
+// totals of what happened over a number of ticks
+struct Tick_totals {
+	int ticks = 0;
+	int arrivals = 0;
+	int deaths = 0;
+	double food_moved = 0.;
+};
+
 // other forward declarations
 struct Structure;
 struct Agent;
 struct View;
 struct Point;
 struct Sim_object;
+class Thread_pool;
+class Event_stream;
  
 class Model {
 public:
-	// asks model to retrieve the instance of model that exists in static memory
+	// create a world; unless told otherwise, it starts out with the initial group of objects
+	explicit Model(bool populate = true);
+	~Model();
+
+	// asks model to retrieve the default instance of model that exists in static memory
 	static Model& get_Model();
 
 	// return the current time
@@ -49,6 +146,7 @@ public:
 	// is there a structure with this name?
 	bool is_structure_present(const std::string& name) const;
 	// add a new structure; assumes none with the same name
+	// during a tick, it is added once the tick is over
 	void add_structure(std::shared_ptr<Structure>);
 	// will throw Error("Structure not found!") if no structure of that name
 	std::shared_ptr<Structure> get_structure_ptr(const std::string& name) const;
@@ -56,16 +154,99 @@ public:
 	// is there an agent with this name?
 	bool is_agent_present(const std::string& name) const;
 	// add a new agent; assumes none with the same name
+	// during a tick, it is added once the tick is over
 	void add_agent(std::shared_ptr<Agent>);
 	// will throw Error("Agent not found!") if no agent of that name
 	std::shared_ptr<Agent> get_agent_ptr(const std::string& name) const;
+	// tell the model that the agent with this ID is now at location
+	void update_agent_location(int id, Point location);
+	// the number of agents there are
+	int get_agent_count() const
+		{return int(entities.get_ids(Entity_store::Kind::AGENT).size());}
 	
 	// tell all objects to describe themselves to the console
 	void describe() const;
 	// increment the time, and tell all objects to update themselves
 	void update();
+	// update ticks times; with chatter off, stretches of ticks in which the objects
+	// do nothing but travel and produce are skipped over in one go (see fast_forward)
+	void run(int ticks);
+
+	// write the whole world to a checkpoint file
+	// will throw Error if the file can't be written
+	void save_checkpoint(const std::string& filename) const;
+	// replace the whole world with the one saved in a checkpoint file, and bring the views up to date
+	// will throw Error if the file can't be read or isn't a sensible checkpoint; the world is then left as it was
+	void load_checkpoint(const std::string& filename);
+	// when chatter is off, the messages objects print while updating are thrown away;
+	// the objects still have something to say if there's an event stream to record it in
+	bool is_chatty() const
+		{return chatter || event_stream;}
+	bool is_chatter_on() const
+		{return chatter;}
+	// with chatter back on, objects that only have something to say get updated again
+	void set_chatter(bool chatter_);
+	// when the production reports are on, each Farm prints how much it has on every tick;
+	// otherwise Farms aren't updated at all
+	bool are_production_reports_on() const
+		{return production_reports;}
+	void set_production_reports(bool production_reports_);
+
+	// what this world prints through; whoever drives the Model makes it current (Output_scope)
+	// for what they print themselves
+	Output& get_output()
+		{return output;}
 
-	// removes the agent from the appropriate containers
+	// the stream the objects record their events in, or nullptr if none is open; see Event_stream.h
+	Event_stream* get_event_stream()
+		{return event_stream.get();}
+	// start recording events in a stream written to the file descriptor fd, closing any
+	// stream that's already open; the objects there are now are named in it first
+	void open_event_stream(int fd);
+	// write out what's left of the event stream and stop recording events;
+	// will throw Error("Could not write the event stream!") if it can't be written
+	void close_event_stream();
+
+	// the totals of what happened since they were last cleared
+	const Tick_totals& get_totals() const
+		{return totals;}
+	void clear_totals()
+		{totals = Tick_totals();}
+	// tell the model that something worth counting happened
+	void record_arrival()
+		{++totals.arrivals;}
+	void record_death()
+		{++totals.deaths;}
+	void record_food_moved(double amount)
+		{totals.food_moved += amount;}
+
+	// print where the ticks have spent their time since the stats were last cleared,
+	// and clear them; will throw Error("Profiling is not compiled in!") if it isn't
+	void describe_stats() const;
+	void clear_stats();
+#ifdef PROFILING
+	Profiler& get_profiler()
+		{return profiler;}
+#endif
+
+	// number of threads update uses; 1, the default, means the usual sequential update
+	int get_thread_count() const;
+	void set_thread_count(int thread_count);
+	// where other objects should see the agent: during a parallel update this is
+	// where it was at the start of the tick, otherwise it's simply where it is
+	Point get_observed_location(const Agent& agent) const;
+	// during a parallel update, if the transfer of the agent with this ID has been
+	// settled ahead of time, copy it into transfer and return true; otherwise false
+	bool take_transfer_result(int id, Transfer& transfer);
+
+	// tell the model that the object with this ID has something to do, so that it gets updated
+	void activate(int id);
+	// the last tick whose update of the object with this ID is over: the current time,
+	// unless a tick is under way and the object's turn in it hasn't come yet
+	int get_time_updated(int id) const;
+
+	// removes the agent from the appropriate containers; during a tick,
+	// it is removed once the tick is over, and until then skipped wherever it matters
 	void remove_agent(std::shared_ptr<Agent>);
 	
 	/* View services */
@@ -75,33 +256,112 @@ public:
 	// Detach the View by discarding the supplied pointer from the container of Views
     // - no updates sent to it thereafter.
 	void detach(std::string view_name);
+	// the table of interned names; Views use it to print names
+	const Symbol_table& get_symbols() const
+		{return symbols;}
+	// The notify functions tell the views right away, except during update, when the
+	// changes are queued up and delivered to the views when the update is done.
     // notify the views about an object's location
-	void notify_location(const std::string& name, Point location);
+	void notify_location(int symbol, Point location);
 	// notify the views about an object's amount
-	void notify_amount(const std::string& name, double amount);
+	void notify_amount(int symbol, double amount);
 	// notify the views about an object's health
-	void notify_health(const std::string& name, double health);
+	void notify_health(int symbol, double health);
 	// notify the views that an object is now gone
-	void notify_gone(const std::string& name);
-	// tells all the views in views to draw themselves
+	void notify_gone(int symbol);
+	// tells all the views in views to draw themselves, or with delta drawing on,
+	// to draw only what has changed since they last drew (see Views.h)
 	void draw_all_views();
+	bool is_delta_drawing_on() const
+		{return delta_drawing;}
+	void set_delta_drawing(bool delta_drawing_)
+		{delta_drawing = delta_drawing_;}
 	// returns a shared pointer to the named view
 	std::shared_ptr<View> get_view(const std::string& view_name);
 
-	// returns a weak_ptr to the closest agent to location
+	// returns a shared_ptr to the closest other agent; if several are equally close,
+	// the alphabetically first one. If there are no other agents, returns current_agent.
 	std::shared_ptr<Agent> get_closest_agent(std::shared_ptr<Agent> current_agent);
-	// returns a weak_ptr to the closes structure to location
+	// returns all the agents no further than radius from center, in alphabetical order
+	std::vector<std::shared_ptr<Agent>> get_agents_within(Point center, double radius);
+	// returns a shared_ptr to the closest structure; if several are equally close,
+	// the alphabetically first one. Returns nullptr if there are no structures.
 	std::shared_ptr<Structure> get_closest_structure(std::shared_ptr<Agent> current_agent);
 	
 private:
-	// make Model a singleton by making the constructor private
-	Model();
 
 	int time;
+	// made current by const functions too, to print through
+	mutable Output output;
+	bool chatter;
+	bool production_reports;
+	bool delta_drawing;
+	Tick_totals totals;
+	std::unique_ptr<Event_stream> event_stream;
 	
-	std::map<std::string, std::shared_ptr<Sim_object> > sim_objs;
-	std::map<std::string, std::shared_ptr<Structure> > structure_objs;
-	std::map<std::string, std::shared_ptr<Agent> > agent_objs;
+	// the movement state of every agent, by ID
+	Kinematics kinematics;
+	// every Structure and Agent, indexed by ID and by name
+	Entity_store entities;
+	// every name ever given to an object
+	Symbol_table symbols;
+	// the location of every agent, by ID
+	Spatial_grid agent_grid;
+	// the location of every structure, by ID; rebuilt when stale
+	Kd_tree structure_tree;
+	bool structure_tree_stale;
+
+	// threads for the parallel update; null when updating sequentially
+	std::unique_ptr<Thread_pool> thread_pool;
+	// state for the parallel update, by ID
+	bool in_parallel_update;
+	std::vector<int> moving_ids;
+	std::vector<Point> frozen_locations;
+	std::vector<char> movements;
+	std::vector<std::string> movement_messages;
+	Ledger ledger;
+
+	// the two ways of updating all the objects
+	void update_sequential();
+	void update_parallel();
+	// skip over as many of the next ticks as can be, up to ticks; returns how many
+	int fast_forward(int ticks);
+	void settle_transfers();
+	void cancel_transfer(int id);
+	void visit_after_movement();
+
+#ifdef PROFILING
+	Profiler profiler;
+#endif
+
+	// the IDs of the objects that have something to do, alphabetically, and whether each ID is there
+	std::vector<int> active_ids;
+	std::vector<char> is_in_active_set;
+	// while walking active_ids, the position of the object being updated
+	bool walking_active;
+	size_t active_cursor;
+	// drop the objects that have nothing left to do from the active set
+	void drop_idle();
+	void deactivate(int id);
+
+	// changes to the containers, held back while updating
+	Mutation_buffer mutations;
+	bool deferring_mutations;
+	// make the held back changes
+	void apply_mutations();
+	// is the object with this ID still taking part: live, and if an agent, alive?
+	bool is_active(int id) const;
+
+	// changes for the views, held back while updating
+	Notification_queue notifications;
+	bool batching_notifications;
+	// send the queued up changes to the views
+	void deliver_notifications();
+
+	// intern the object's name and add it to the entity store
+	void register_object(std::shared_ptr<Sim_object> object, Entity_store::Kind kind);
+	// take the agent with this ID out of the containers
+	void erase_agent(int id);
 
 	// used by models constructor
 	void insert_Agent(std::shared_ptr<Agent>);
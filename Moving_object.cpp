@@ -1,8 +1,42 @@
 #include "Moving_object.h"
+#include <algorithm>
+#include <cfloat>
+#include <climits>
 #include <cmath>
 
 using std::fabs;
+using std::ilogb;
+using std::isfinite;
+using std::ldexp;
+using std::max;
+using std::min;
+using std::round;
+using std::trunc;
 
+static long long exact_run(double x, double d, double& rounded_d);
+static long long failing_run(double location, double destination, double d, double rounded_d, long long cap);
+
+// keep the state in slot of kinematics_ from now on;
+// a null kinematics_ takes the state back from wherever it is now
+void Moving_object::bind(Kinematics* kinematics_, int slot_)
+{
+	if (kinematics) {
+		state = kinematics->get(slot);
+		kinematics->remove(slot);
+	}
+	kinematics = kinematics_;
+	slot = slot_;
+	if (kinematics)
+		kinematics->add(slot, state);
+}
+
+void Moving_object::set_state(const Kinematic_state& state_)
+{
+	if (kinematics)
+		kinematics->set(slot, state_);
+	else
+		state = state_;
+}
 	
 // Tell this object to start moving to location in_destination
 // If it is already at the destination and moving, it stops;
@@ -10,57 +44,194 @@ using std::fabs;
 // Otherwise, it starts moving, advancing by delta on each update call.
 void Moving_object::start_moving(Point destination_)
 {
-	if(location == destination_) {
-		if(moving) {
+	Kinematic_state current = get_state();
+	if(current.location == destination_) {
+		if(current.moving) {
 			stop_moving();
 			}
 		return;
 		}
 	// time to start moving
-	moving = true;
-	destination = destination_;
-	compute_delta();
+	current.moving = true;
+	current.destination = destination_;
+	compute_delta(current);
+	set_state(current);
 }
 
 // change the speed by recomputing the delta if we are moving
 void Moving_object::set_speed(double speed_)
 {
-	speed = speed_;
+	Kinematic_state current = get_state();
+	current.speed = speed_;
 	// recompute the delta to get to the same destination
-	if(moving)
-		compute_delta();
+	if(current.moving)
+		compute_delta(current);
+	set_state(current);
 }
 
 // call stop to tell this object to stop whatever it is doing
 // reset the delta and the destination to make it more obvious that we aren't moving
 void Moving_object::stop_moving()
 {
-	moving = false;
-	delta = Cartesian_vector();
-	destination = Point();
+	Kinematic_state current = get_state();
+	current.moving = false;
+	current.delta = Cartesian_vector();
+	current.destination = Point();
+	set_state(current);
 }
 
 // If the destination is within one delta step away, the object has arrived.
 // Set the location to the destination, stop, and return true.
 // Otherwise, add the delta to the location, and return false.
+// If the step has already been worked out by our Kinematics, just take it.
 bool Moving_object::update_location()
 {
-	Cartesian_vector diff = destination - location;
-	if ((fabs(diff.delta_x) <= fabs(delta.delta_x)) && (fabs(diff.delta_y) <= fabs(delta.delta_y))) {
-		location = destination;
+	bool arrived;
+	if (kinematics && kinematics->take_step(slot, arrived))
+		return arrived;
+
+	Kinematic_state current = get_state();
+	Cartesian_vector diff = current.destination - current.location;
+	if ((fabs(diff.delta_x) <= fabs(current.delta.delta_x)) && (fabs(diff.delta_y) <= fabs(current.delta.delta_y))) {
+		current.location = current.destination;
+		set_state(current);
 		stop_moving();
 		return true;
 		}
-	location = location + delta;
+	current.location = current.location + current.delta;
+	set_state(current);
 	return false;
 }
 
-// use the Geometry operators to compute the delta change in x and y per update
-void Moving_object::compute_delta()
+// Work out what ticks calls of update_location would do, without making them.
+// Returns the number of the call (1 is the next) in which the object would arrive, or 0 if none.
+int Moving_object::get_ticks_to_arrival(int ticks) const
 {
-	delta = (destination - location) * (speed / cartesian_distance(destination, location));
+	Kinematic_state current = get_state();
+	return advance(current, ticks);
 }
 
-	
+// Make ticks calls of update_location in one go; returns the number of the call
+// in which the object arrived, or 0 if it didn't.
+int Moving_object::fast_forward(int ticks)
+{
+	Kinematic_state current = get_state();
+	int arrival = advance(current, ticks);
+	set_state(current);
+	return arrival;
+}
+
+// Do to state_ what ticks calls of update_location would, and return the number of the call
+// in which it arrives, or 0. Rather than one step at a time, the steps are taken in runs:
+// as many at once as can be taken exactly (see exact_run) while the arrival test surely fails
+// (see failing_run). If no run can be taken, e.g. at the edge of a binade, a single step is.
+// A run ends only at a binade edge, at the arrival, or at the end of the ticks, so even
+// a very long trip takes just a few runs.
+int Moving_object::advance(Kinematic_state& state_, int ticks)
+{
+	if (!state_.moving)
+		return 0;
+	for (int done = 0; done < ticks;) {
+		// the same arrival test as update_location
+		Cartesian_vector diff = state_.destination - state_.location;
+		if ((fabs(diff.delta_x) <= fabs(state_.delta.delta_x)) && (fabs(diff.delta_y) <= fabs(state_.delta.delta_y))) {
+			state_.location = state_.destination;
+			state_.moving = false;
+			state_.delta = Cartesian_vector();
+			state_.destination = Point();
+			return done + 1;
+		}
+		double step_x, step_y;
+		long long cap = min(min(static_cast<long long>(ticks - done),
+			exact_run(state_.location.x, state_.delta.delta_x, step_x)),
+			exact_run(state_.location.y, state_.delta.delta_y, step_y));
+		if (cap == 0) {
+			state_.location = state_.location + state_.delta;
+			++done;
+			continue;
+		}
+		// the test fails at the current location, so at least one step can be taken
+		long long run = max(
+			failing_run(state_.location.x, state_.destination.x, state_.delta.delta_x, step_x, cap),
+			failing_run(state_.location.y, state_.destination.y, state_.delta.delta_y, step_y, cap));
+		state_.location = Point(state_.location.x + run * step_x, state_.location.y + run * step_y);
+		done += int(run);
+	}
+	return 0;
+}
+
+// Adding a fixed d to x over and over is exact arithmetic in disguise as long as the sums
+// stay inside x's binade (the doubles with the same exponent as x): each sum is then exactly
+// the previous one plus d rounded to a multiple of x's ulp, so after k additions x has become
+// x + k * rounded_d, which is exactly representable. Returns how many additions in a row
+// that holds for, and sets rounded_d; returns 0 if it can't be sure of even one, which is the
+// case near zero, within an ulp of the edge of the binade, and if d is exactly halfway
+// between multiples of the ulp (the rounding would then depend on x).
+static long long exact_run(double x, double d, double& rounded_d)
+{
+	rounded_d = 0.;
+	// adding zero never changes x (except -0. to 0., and -0. + k * 0. does that too)
+	if (d == 0.)
+		return LLONG_MAX;
+	double magnitude = fabs(x);
+	if (!(magnitude >= DBL_MIN) || !isfinite(magnitude) || !isfinite(d))
+		return 0;
+	int exponent = ilogb(magnitude);
+	double ulp = ldexp(1., exponent - (DBL_MANT_DIG - 1));
+	// staying an ulp inside the binade, rounding can't take a sum out of it
+	double low = ldexp(1., exponent) + ulp;
+	double high = ldexp(1., exponent + 1) - ulp;
+	if (magnitude < low || magnitude > high)
+		return 0;
+	double units = d / ulp;
+	if (fabs(units - trunc(units)) == 0.5)
+		return 0;
+	units = round(units);
+	rounded_d = units * ulp;
+	if (units == 0.)
+		return LLONG_MAX;
+	// in ulps, the room left in the direction the magnitude is going
+	bool growing = (units > 0.) == (x > 0.);
+	double room = (growing ? high - magnitude : magnitude - low) / ulp;
+	if (fabs(units) > room)
+		return 0;
+	return static_cast<long long>(room) / static_cast<long long>(fabs(units));
+}
 
+// Of the locations location + j * rounded_d, for j from 0 up to cap - 1, the number of those
+// in a row from the first at which update_location's arrival test surely fails for this axis.
+// Going away from the destination, or standing still, the distance left never shrinks, so if
+// the test fails now, it always will. Getting closer, it fails until the destination is close
+// enough or has been passed, and the last location before that is found by bisection.
+static long long failing_run(double location, double destination, double d, double rounded_d, long long cap)
+{
+	auto fails_at = [=](long long j)
+		{return !(fabs(destination - (location + j * rounded_d)) <= fabs(d));};
+	if (!fails_at(0))
+		return 0;
+	bool approaching = (rounded_d > 0. && destination > location) || (rounded_d < 0. && destination < location);
+	if (!approaching)
+		return cap;
+	auto short_of = [=](long long j) {
+		double here = location + j * rounded_d;
+		return fails_at(j) && (rounded_d > 0. ? here <= destination : here >= destination);
+	};
+	long long first = 0, last = cap - 1;
+	if (short_of(last))
+		return cap;
+	// short_of(first) holds and short_of(last) doesn't
+	while (last - first > 1) {
+		long long middle = first + (last - first) / 2;
+		if (short_of(middle))
+			first = middle;
+		else
+			last = middle;
+	}
+	return first + 1;
+}
 
+// use the Geometry operators to compute the delta change in x and y per update
+void Moving_object::compute_delta(Kinematic_state& state_)
+{
+	state_.delta = (state_.destination - state_.location) * (state_.speed / cartesian_distance(state_.destination, state_.location));
+}
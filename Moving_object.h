@@ -1,27 +1,42 @@
 #ifndef MOVING_OBJECT
 #define MOVING_OBJECT
 #include "Geometry.h"
+#include "Kinematics.h"
 /* Moving_object encapsulates the calculations needed to make an object move 
 from one point to another, moving a specified distance on each update_location call.
+Many calls can be made in one go with fast_forward, which works out in closed form
+where they would leave the object, and on which call it would arrive.
+The state is kept in the object itself until it is bound to a slot of a Kinematics,
+which then keeps it, so that the steps of many objects can be worked out together.
 */
 
 class Moving_object {
 public:
 	Moving_object() :
-		moving(false) {}
+		kinematics(nullptr), slot(0), state{false, Point(), 0., Point(), Cartesian_vector()} {}
 	Moving_object(Point location_, double speed_) :
-		moving(false), location(location_), speed(speed_) {}
+		kinematics(nullptr), slot(0), state{false, location_, speed_, Point(), Cartesian_vector()} {}
 
 	// readers
 	bool is_currently_moving() const
-		{return moving;}
+		{return kinematics ? kinematics->is_moving(slot) : state.moving;}
 	Point get_current_location() const
-		{return location;}
+		{return kinematics ? kinematics->get_location(slot) : state.location;}
 	double get_current_speed() const
-		{return speed;}
+		{return get_state().speed;}
 	Point get_current_destination() const
-		{return destination;}
+		{return get_state().destination;}
+	Cartesian_vector get_current_delta() const
+		{return get_state().delta;}
 	
+	// put this object back in a previously saved state, exactly as it was
+	void restore(bool moving_, Point location_, double speed_, Point destination_, Cartesian_vector delta_)
+		{set_state(Kinematic_state{moving_, location_, speed_, destination_, delta_});}
+
+	// keep the state in slot of kinematics_ from now on;
+	// a null kinematics_ takes the state back from wherever it is now
+	void bind(Kinematics* kinematics_, int slot_);
+
 	// Tell this object to start moving to location destination.
 	// If it is already at the destination and moving, it stops;
 	// if already there and not moving, it stays stopped.
@@ -34,16 +49,26 @@ public:
 	// update this object's location using current location, speed, and destination
 	// returns true if arrived at destination, false if not
 	bool update_location();
+	// Work out what ticks calls of update_location would do, without making them.
+	// Returns the number of the call (1 is the next) in which the object would arrive, or 0 if none.
+	int get_ticks_to_arrival(int ticks) const;
+	// Make ticks calls of update_location in one go, leaving the location bit for bit
+	// where they would have left it. Returns the number of the call in which the object
+	// arrived, and stopped, or 0 if it didn't arrive.
+	int fast_forward(int ticks);
 
 private:
-	bool moving;			// true if this object is moving
-	Point location;			// current location
-	double speed;			// distance moved per update
-	Point destination;		// destination to move to
-	Cartesian_vector delta;	// x, y increments per update
+	Kinematics* kinematics;		// where the state is kept, if bound
+	int slot;
+	Kinematic_state state;		// the state, if not bound
+
+	Kinematic_state get_state() const
+		{return kinematics ? kinematics->get(slot) : state;}
+	void set_state(const Kinematic_state& state_);
 	
 	// helpers
-	void compute_delta();
+	static void compute_delta(Kinematic_state& state_);
+	static int advance(Kinematic_state& state_, int ticks);
 };
 
 #endif
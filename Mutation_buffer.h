@@ -0,0 +1,47 @@
+#ifndef MUTATION_BUFFER_H
+#define MUTATION_BUFFER_H
+/*
+Mutation_buffer holds the structural changes to Model's containers - objects being
+added and Agents being removed - that are asked for while a tick is in progress,
+so that the containers stay fixed while the tick walks them. Model applies the
+changes in one sweep, in the order they were asked for, once the tick is over.
+Until then, an Agent that has died is still in the containers, and Model skips it
+wherever it matters; an object that is being added isn't there yet.
+(The Views' notify_gone calls are held back the same way by the Notification_queue.)
+*/
+#include "Entity_store.h"
+
+#include <memory>
+#include <vector>
+
+class Sim_object;
+
+class Mutation_buffer {
+public:
+	struct Mutation {
+		bool insertion;			// an insertion, or else a removal
+		std::shared_ptr<Sim_object> object;
+		Entity_store::Kind kind;
+	};
+
+	bool empty() const
+		{return mutations.empty();}
+
+	void queue_insertion(std::shared_ptr<Sim_object> object, Entity_store::Kind kind)
+		{mutations.push_back(Mutation{true, object, kind});}
+	void queue_removal(std::shared_ptr<Sim_object> object, Entity_store::Kind kind)
+		{mutations.push_back(Mutation{false, object, kind});}
+
+	// return the queued changes in the order they were queued, and forget them
+	std::vector<Mutation> take()
+	{
+		std::vector<Mutation> taken;
+		taken.swap(mutations);
+		return taken;
+	}
+
+private:
+	std::vector<Mutation> mutations;
+};
+
+#endif
@@ -0,0 +1,69 @@
+#include "Notification_queue.h"
+#include "View.h"
+using namespace std;
+
+void Notification_queue::record_location(int symbol, Point location)
+{
+	Pending& change = pending_for(symbol);
+	change.has_location = true;
+	change.location = location;
+}
+
+void Notification_queue::record_amount(int symbol, double amount)
+{
+	Pending& change = pending_for(symbol);
+	change.has_amount = true;
+	change.amount = amount;
+}
+
+void Notification_queue::record_health(int symbol, double health)
+{
+	Pending& change = pending_for(symbol);
+	change.has_health = true;
+	change.health = health;
+}
+
+// record that the object is gone, discarding the changes recorded for it so far
+void Notification_queue::record_gone(int symbol)
+{
+	Pending& change = pending_for(symbol);
+	change.gone = true;
+	change.has_location = change.has_amount = change.has_health = false;
+}
+
+// tell the view about every recorded change
+// a removal comes first, so anything recorded after it still shows up
+void Notification_queue::deliver(View& view) const
+{
+	for (int symbol : touched) {
+		const Pending& change = pending[symbol];
+		if (change.gone)
+			view.update_remove(symbol);
+		if (change.has_location)
+			view.update_location(symbol, change.location);
+		if (change.has_amount)
+			view.update_amount(symbol, change.amount);
+		if (change.has_health)
+			view.update_health(symbol, change.health);
+	}
+}
+
+// forget all the recorded changes
+void Notification_queue::clear()
+{
+	for (int symbol : touched)
+		pending[symbol] = Pending();
+	touched.clear();
+}
+
+Notification_queue::Pending& Notification_queue::pending_for(int symbol)
+{
+	if (symbol >= int(pending.size()))
+		pending.resize(symbol + 1);
+	Pending& change = pending[symbol];
+	if (!change.touched) {
+		change.touched = true;
+		touched.push_back(symbol);
+	}
+	return change;
+}
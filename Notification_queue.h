@@ -0,0 +1,51 @@
+#ifndef NOTIFICATION_QUEUE_H
+#define NOTIFICATION_QUEUE_H
+/*
+Notification_queue collects the changes Model would otherwise pass on to the Views
+right away, so that they can be delivered in one batch at the end of a tick.
+Changes are merged per object, identified by its symbol: only the latest location,
+amount, and health of each object are kept, and an object being gone discards
+whatever was recorded for it before. The Views end up in the same state as if
+they had been told about every change as it happened.
+*/
+#include "Geometry.h"
+
+#include <vector>
+
+class View;
+
+class Notification_queue {
+public:
+	bool empty() const
+		{return touched.empty();}
+
+	// record a change, replacing any earlier change of the same kind to the same object
+	void record_location(int symbol, Point location);
+	void record_amount(int symbol, double amount);
+	void record_health(int symbol, double health);
+	// record that the object is gone, discarding the changes recorded for it so far
+	void record_gone(int symbol);
+
+	// tell the view about every recorded change, objects in the order they were first changed
+	void deliver(View& view) const;
+	// forget all the recorded changes
+	void clear();
+
+private:
+	struct Pending {
+		bool touched = false;
+		bool gone = false;
+		bool has_location = false;
+		bool has_amount = false;
+		bool has_health = false;
+		Point location;
+		double amount = 0.;
+		double health = 0.;
+	};
+	std::vector<Pending> pending;	// by symbol
+	std::vector<int> touched;		// symbols with something recorded
+
+	Pending& pending_for(int symbol);
+};
+
+#endif
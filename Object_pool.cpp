@@ -0,0 +1,58 @@
+#include "Object_pool.h"
+
+#include <algorithm>
+#include <new>
+using namespace std;
+
+// the first chunk holds this many blocks, and each one after that twice as many, up to the maximum
+static const size_t first_chunk_blocks_c {64};
+static const size_t max_chunk_blocks_c {4096};
+
+Fixed_pool::Fixed_pool(size_t block_size_, size_t alignment)
+:
+chunk_blocks {first_chunk_blocks_c},
+next_unused {nullptr},
+chunk_end {nullptr},
+free_list {nullptr}
+{
+	// every block has to be big enough to hold the free list link, and stay aligned
+	alignment = max(alignment, alignof(Free_block));
+	block_size = max(block_size_, sizeof(Free_block));
+	block_size = (block_size + alignment - 1) / alignment * alignment;
+}
+
+Fixed_pool::~Fixed_pool()
+{
+	for (char* chunk : chunks)
+		::operator delete(chunk);
+}
+
+// reuse the most recently freed block, otherwise take the next unused one
+void* Fixed_pool::allocate()
+{
+	lock_guard<mutex> lock(mtx);
+	if (free_list) {
+		Free_block* block = free_list;
+		free_list = block->next;
+		return block;
+	}
+	if (next_unused == chunk_end) {
+		// memory from operator new is aligned well enough for anything ordinary
+		char* chunk = static_cast<char*>(::operator new(chunk_blocks * block_size));
+		chunks.push_back(chunk);
+		next_unused = chunk;
+		chunk_end = chunk + chunk_blocks * block_size;
+		chunk_blocks = min(chunk_blocks * 2, max_chunk_blocks_c);
+	}
+	void* block = next_unused;
+	next_unused += block_size;
+	return block;
+}
+
+void Fixed_pool::deallocate(void* block)
+{
+	lock_guard<mutex> lock(mtx);
+	Free_block* freed = static_cast<Free_block*>(block);
+	freed->next = free_list;
+	free_list = freed;
+}
@@ -0,0 +1,89 @@
+#ifndef OBJECT_POOL_H
+#define OBJECT_POOL_H
+/*
+Object pools for the simulation objects the factories create.
+
+Fixed_pool hands out blocks of memory that are all the same size. It carves them out
+of large chunks, and a block that is given back goes on a free list and is the
+next one handed out, so a new object often takes the place of one that has just died.
+Chunks are never given back to the system.
+
+Pool_allocator is a standard allocator that takes single objects from a Fixed_pool
+of its own, one pool per type. The factories use it with std::allocate_shared, which
+puts the object and its shared_ptr control block together in one allocation of an
+internal type. That type differs for each kind of object, so each kind gets its own pool.
+The pools are never destroyed, because objects (e.g. those of the default Model)
+can outlive the other statics. A pool can be used from several threads.
+*/
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+class Fixed_pool {
+public:
+	Fixed_pool(std::size_t block_size_, std::size_t alignment);
+	~Fixed_pool();
+
+	void* allocate();
+	void deallocate(void* block);
+
+private:
+	// a freed block holds the link to the next free one
+	struct Free_block {
+		Free_block* next;
+	};
+
+	std::size_t block_size;
+	std::size_t chunk_blocks;		// blocks in the next chunk
+	std::vector<char*> chunks;
+	char* next_unused;				// the rest of the newest chunk, never handed out yet
+	char* chunk_end;
+	Free_block* free_list;
+	std::mutex mtx;
+
+	Fixed_pool(const Fixed_pool&) = delete;
+	Fixed_pool& operator= (const Fixed_pool&) = delete;
+};
+
+template<typename T>
+class Pool_allocator {
+public:
+	using value_type = T;
+
+	Pool_allocator() noexcept {}
+	template<typename U>
+	Pool_allocator(const Pool_allocator<U>&) noexcept {}
+
+	// single objects come from the pool, anything else from the usual place
+	T* allocate(std::size_t n)
+	{
+		if (n != 1)
+			return std::allocator<T>().allocate(n);
+		return static_cast<T*>(pool().allocate());
+	}
+	void deallocate(T* p, std::size_t n)
+	{
+		if (n != 1)
+			std::allocator<T>().deallocate(p, n);
+		else
+			pool().deallocate(p);
+	}
+
+private:
+	static Fixed_pool& pool()
+	{
+		static Fixed_pool* the_pool = new Fixed_pool(sizeof(T), alignof(T));
+		return *the_pool;
+	}
+};
+
+// all Pool_allocators draw on the same pools, so any one can free what another allocated
+template<typename T, typename U>
+bool operator== (const Pool_allocator<T>&, const Pool_allocator<U>&)
+	{return true;}
+template<typename T, typename U>
+bool operator!= (const Pool_allocator<T>&, const Pool_allocator<U>&)
+	{return false;}
+
+#endif
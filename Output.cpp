@@ -0,0 +1,58 @@
+#include "Output.h"
+
+#include <iostream>
+using namespace std;
+
+// the Output an Output_scope has made current on this thread, if any
+static thread_local Output* current_output = nullptr;
+
+Output& Output::get_Output()
+{
+	if (current_output)
+		return *current_output;
+	static Output output;
+	return output;
+}
+
+Output::Output() :
+Output(cout)
+{}
+
+Output::Output(ostream& os_) :
+os(&os_),
+discard(nullptr),
+minimum_level {Level_e::CHATTER},
+null_count {0}
+{}
+
+ostream& Output::get_stream(Level_e level)
+{
+	return is_printed(level) ? *os : discard;
+}
+
+void Output::flush()
+{
+	os->flush();
+}
+
+Output_scope::Output_scope(Output& output) :
+saved(current_output)
+{
+	current_output = &output;
+}
+
+Output_scope::~Output_scope()
+{
+	current_output = saved;
+}
+
+Output_suppressor::Output_suppressor() :
+output(Output::get_Output())
+{
+	++output.null_count;
+}
+
+Output_suppressor::~Output_suppressor()
+{
+	--output.null_count;
+}
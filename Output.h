@@ -0,0 +1,109 @@
+#ifndef OUTPUT_H
+#define OUTPUT_H
+/*
+Everything the program prints goes through the Output sink, rather than straight
+to cout. What's printed is at one of three levels:
+	CHATTER		what the objects say for themselves, e.g. "Bug: Ouch!", "Farm Shire now has 52.00"
+	EVENTS		everything else the user is shown: the prompts, descriptions, views and summaries
+	ERRORS		the error messages
+The sink prints only what's at its level or above, and nothing at all while it's
+null (see Output_suppressor). What isn't printed goes to a stream that fails at
+once, so it isn't even formatted.
+
+Lines end with '\n' rather than endl, so that printing a line doesn't flush it, and
+a run of output redirected to a file is written in a few big writes rather than one
+per line. The sink is flushed at the end of every tick, and cin is tied to cout, so
+what has been printed is flushed before a command is read. When cout is a terminal,
+the C library's stdout is line buffered, so each line still shows up as it's printed.
+
+Each Model has an Output of its own, so that worlds run on threads of their own
+each have their own level, and a quiet one doesn't silence the others. What's
+printed goes to the current Output of the thread printing it: the one an
+Output_scope has made current, or else a default one. A Model makes its Output
+current while it updates, describes itself or draws its views, and whoever
+drives it (e.g. the Controller) does so for what they print in between. An Output
+is only ever used by one thread at a time: what the Agents print while moving in
+parallel is held back in strings (see Model::update_parallel). Worlds run at the
+same time should be given streams of their own, since they can't share cout.
+*/
+#include <ostream>
+
+class Output {
+public:
+	enum class Level_e { CHATTER, EVENTS, ERRORS };
+
+	// an Output writing to cout, or to os_, and printing everything
+	Output();
+	explicit Output(std::ostream& os_);
+
+	// the current Output of this thread: the one an Output_scope has made current,
+	// or else the default one, which writes to cout
+	static Output& get_Output();
+
+	// the stream to print what's at this level to; if it wouldn't be printed,
+	// a stream that throws it away
+	std::ostream& get_stream(Level_e level);
+	// would what's at this level be printed?
+	bool is_printed(Level_e level) const
+		{return null_count == 0 && level >= minimum_level;}
+	// shorthands for the Output's streams
+	static std::ostream& chatter()
+		{return get_Output().get_stream(Level_e::CHATTER);}
+	static std::ostream& events()
+		{return get_Output().get_stream(Level_e::EVENTS);}
+	static std::ostream& errors()
+		{return get_Output().get_stream(Level_e::ERRORS);}
+
+	// print only what's at this level or above
+	Level_e get_level() const
+		{return minimum_level;}
+	void set_level(Level_e level)
+		{minimum_level = level;}
+
+	// write out whatever has been printed but is still buffered
+	void flush();
+	// the stream printed to, whatever the levels, e.g. to copy its format
+	std::ostream& get_destination() const
+		{return *os;}
+	// print to os_ from now on
+	void set_destination(std::ostream& os_)
+		{os = &os_;}
+
+private:
+	Output(const Output&) = delete;
+	Output& operator= (const Output&) = delete;
+
+	std::ostream* os;
+	std::ostream discard;	// has no buffer, so anything written to it fails
+	Level_e minimum_level;
+	int null_count;
+
+	friend class Output_suppressor;
+};
+
+// While one of these exists, the Output it's given is this thread's current Output.
+class Output_scope {
+public:
+	explicit Output_scope(Output& output);
+	~Output_scope();
+private:
+	Output* saved;
+
+	Output_scope(const Output_scope&) = delete;
+	Output_scope& operator= (const Output_scope&) = delete;
+};
+
+// While at least one of these exists, the Output that was current when it was
+// created is null, and prints nothing at all.
+class Output_suppressor {
+public:
+	Output_suppressor();
+	~Output_suppressor();
+private:
+	Output& output;
+
+	Output_suppressor(const Output_suppressor&) = delete;
+	Output_suppressor& operator= (const Output_suppressor&) = delete;
+};
+
+#endif
@@ -1,8 +1,11 @@
 #include "Peasant.h"
+#include "Checkpoint.h"
+#include "Event_stream.h"
+#include "Ledger.h"
 #include "Model.h"
+#include "Output.h"
 #include "Structure.h"
 #include "Utility.h"
-#include <iostream>
 using namespace std;
 
 static const int max_food {35};
@@ -11,14 +14,14 @@ Peasant::Peasant(const string& name_, Point location_)
 :
 Agent(name_, location_),
 working_state {Working_State_e::NOT_WORKING},
-amount {0}
+amount {0},
+asleep {false}
 { }
 
 // implement Peasant behavior
-void Peasant::update()
+void Peasant::update_behavior()
 {
-	// first update agent's state
-	Agent::update();
+	PROFILE_PHASE(get_model(), PEASANT_WORK);
 	// check if the agent's alive or not moving
 	if (!Agent::is_alive() || working_state == Working_State_e::NOT_WORKING) {
 		// do nothing
@@ -34,17 +37,32 @@ void Peasant::update()
 			break;
 		}
 		case Working_State_e::COLLECTING: {
+			if (asleep) {
+				// nothing has come in since we last tried
+				Output::chatter() << get_name() << ": Waiting \n";
+				if (Event_stream* events = get_model().get_event_stream())
+					events->record_waiting(get_symbol(), source->get_symbol());
+				break;
+			}
 			double request = max_food - amount;
-			double received = source->withdraw(request);
+			// the withdrawal may have been made ahead of time
+			Transfer transfer {};
+			double received = get_model().take_transfer_result(get_id(), transfer) ?
+				transfer.result : source->withdraw(request);
 			amount += received;
-			Model::get_Model().notify_amount(get_name(), amount);
+			get_model().notify_amount(get_symbol(), amount);
 
 			if (received > 0.0) {
-				cout << get_name() << ": Collected " << received << endl;
+				Output::chatter() << get_name() << ": Collected " << received << '\n';
+				if (Event_stream* events = get_model().get_event_stream())
+					events->record_collected(get_symbol(), source->get_symbol(), received);
 				working_state = Working_State_e::OUTBOUND;
 				Agent::move_to(destination->get_location());
 			} else {
-				cout << get_name() << ": Waiting " << endl;
+				Output::chatter() << get_name() << ": Waiting \n";
+				if (Event_stream* events = get_model().get_event_stream())
+					events->record_waiting(get_symbol(), source->get_symbol());
+				asleep = source->add_waiter(shared_from_this());
 			}
 			break;
 		}
@@ -54,11 +72,19 @@ void Peasant::update()
 			break;
 		}
 		case Working_State_e::DEPOSITING: {
-			// deposit the amount we're carrying
-			destination->deposit(amount);
-			cout << get_name() << ": Deposited " << amount << endl;
+			// deposit the amount we're carrying; if the deposit has been made ahead of time,
+			// there's only the waiting Agents to wake up
+			Transfer transfer {};
+			if (!get_model().take_transfer_result(get_id(), transfer))
+				destination->deposit(amount);
+			else if (transfer.wakes_waiters)
+				destination->wake_waiters();
+			Output::chatter() << get_name() << ": Deposited " << amount << '\n';
+			if (Event_stream* events = get_model().get_event_stream())
+				events->record_deposited(get_symbol(), destination->get_symbol(), amount);
+			get_model().record_food_moved(amount);
 			amount = 0;
-			Model::get_Model().notify_amount(get_name(), amount);
+			get_model().notify_amount(get_symbol(), amount);
 			Agent::move_to(source->get_location());
 			working_state = Working_State_e::INBOUND;
 			break;
@@ -69,6 +95,64 @@ void Peasant::update()
 	}
 }
 
+bool Peasant::has_pending_work() const
+{
+	if (Agent::has_pending_work())
+		return true;
+	if (!is_alive() || working_state == Working_State_e::NOT_WORKING)
+		return false;
+	return !asleep || get_model().is_chatty();
+}
+
+// On the way to the source or destination, there's nothing to do until we get there;
+// the tick in which we arrive isn't skippable, since we then start to work.
+int Peasant::get_skippable_ticks(int ticks) const
+{
+	if (!is_alive())
+		return ticks;
+	switch(working_state) {
+		case Working_State_e::NOT_WORKING:
+			return Agent::get_skippable_ticks(ticks);
+		case Working_State_e::INBOUND:
+		case Working_State_e::OUTBOUND: {
+			if (!is_moving())
+				return 0;
+			int arrival = get_ticks_to_arrival(ticks);
+			return arrival ? arrival - 1 : ticks;
+		}
+		case Working_State_e::COLLECTING:
+			// asleep, there's nothing to do but say so
+			return asleep ? ticks : 0;
+		case Working_State_e::DEPOSITING:
+		default:
+			return 0;
+	}
+}
+
+void Peasant::wake_up()
+{
+	if (!asleep || !is_alive())
+		return;
+	asleep = false;
+	get_model().activate(get_id());
+}
+
+void Peasant::plan_transfer(Ledger& ledger) const
+{
+	if (!is_alive())
+		return;
+	switch(working_state) {
+		case Working_State_e::COLLECTING:
+			ledger.enter_withdrawal(source->get_id(), get_id(), max_food - amount, asleep);
+			break;
+		case Working_State_e::DEPOSITING:
+			ledger.enter_deposit(destination->get_id(), get_id(), amount);
+			break;
+		default:
+			break;
+	}
+}
+
 void Peasant::stop_working()
 {
 	switch(working_state) {
@@ -76,10 +160,11 @@ void Peasant::stop_working()
 		case Working_State_e::COLLECTING:
 		case Working_State_e::OUTBOUND:
 		case Working_State_e::DEPOSITING:
-			cout << get_name() << ": I'm stopping work" << endl;
+			Output::chatter() << get_name() << ": I'm stopping work\n";
 			working_state = Working_State_e::NOT_WORKING;
 			// note: break intentionally left out
 		case Working_State_e::NOT_WORKING:
+			asleep = false;
 			source.reset();
 			destination.reset();
 			break;
@@ -109,6 +194,7 @@ void Peasant::start_working(shared_ptr<Structure> source_, shared_ptr<Structure>
 {
 	Agent::stop();
 	working_state = Working_State_e::NOT_WORKING;
+	asleep = false;
 	source.reset();
 	destination.reset();
 	// error check
@@ -134,26 +220,27 @@ void Peasant::start_working(shared_ptr<Structure> source_, shared_ptr<Structure>
 			working_state = Working_State_e::OUTBOUND;
 		}
 	}
+	get_model().activate(get_id());
 }
 
 // output information about the current state
 void Peasant::describe() const
 {
-	cout << "Peasant ";
+	Output::events() << "Peasant ";
 	Agent::describe();
-	cout << "   Carrying " << amount << endl;
+	Output::events() << "   Carrying " << amount << '\n';
 	switch(working_state) {
 		case Working_State_e::INBOUND:
-			cout << "   Inbound to source " << source->get_name() << endl;
+			Output::events() << "   Inbound to source " << source->get_name() << '\n';
 			break;
 		case Working_State_e::OUTBOUND:
-			cout << "   Outbound to destination " << destination->get_name() << endl;
+			Output::events() << "   Outbound to destination " << destination->get_name() << '\n';
 			break;
 		case Working_State_e::COLLECTING:
-			cout << "   Collecting at source " << source->get_name() << endl;
+			Output::events() << "   Collecting at source " << source->get_name() << '\n';
 			break;
 		case Working_State_e::DEPOSITING:
-			cout << "   Depositing at destination " << destination->get_name() << endl;
+			Output::events() << "   Depositing at destination " << destination->get_name() << '\n';
 			break;
 		case Working_State_e::NOT_WORKING:
 		default:
@@ -163,6 +250,31 @@ void Peasant::describe() const
 
 void Peasant::broadcast_current_state()
 {
-	Model::get_Model().notify_amount(get_name(), amount);
+	get_model().notify_amount(get_symbol(), amount);
 	Agent::broadcast_current_state();
+}
+
+// also saves the working state, the food carried, and the source and destination
+void Peasant::save_state(Checkpoint_record& record, const Checkpoint_links& links) const
+{
+	Agent::save_state(record, links);
+	record.amount = amount;
+	record.state = int32_t(working_state);
+	record.link_1 = links.record_of(source.get());
+	record.link_2 = links.record_of(destination.get());
+}
+
+void Peasant::restore_state(const Checkpoint_record& record, const Checkpoint_links& links)
+{
+	Agent::restore_state(record, links);
+	if (record.state < int32_t(Working_State_e::INBOUND) || record.state > int32_t(Working_State_e::NOT_WORKING))
+		throw Error("Checkpoint file is corrupt!");
+	amount = record.amount;
+	working_state = Working_State_e(record.state);
+	// a waiting Peasant tries again, and waits again if there's still nothing
+	asleep = false;
+	source = dynamic_pointer_cast<Structure>(links.object_at(record.link_1));
+	destination = dynamic_pointer_cast<Structure>(links.object_at(record.link_2));
+	if (working_state != Working_State_e::NOT_WORKING && (!source || !destination))
+		throw Error("Checkpoint file is corrupt!");
 }
\ No newline at end of file
@@ -4,7 +4,9 @@
 A Peasant is an Agent that can move food between Structures. It can be commanded to
 start_working, whereupon it moves to the source, picks up food, returns to destination,
 deposits the food, returns to source.  If picks up zero food at the source, it waits there
-and tries again on the next update. 
+until the source wakes it up, when there may be food again, and then tries again. 
+In a parallel update, the withdrawal or deposit is made ahead of time, and the Peasant
+takes the result from the Model at its turn; see Ledger.h.
 If commanded to move_to somewhere, it stops working, and goes there.
 */
 #include "Agent.h"
@@ -16,7 +18,12 @@ public:
 	Peasant(const std::string& name_, Point location_);
 
 	// implement Peasant behavior
-	void update() override;
+	void update_behavior() override;
+	// also has something to do while working, except while waiting at an empty source,
+	// when there's nothing to do but say so, if there's chatter to say it
+	bool has_pending_work() const override;
+	// while working, only the ticks spent on the way to the source or destination can be skipped
+	int get_skippable_ticks(int ticks) const override;
 	
 	// overridden to suspend working behavior
     void move_to(Point dest) override;
@@ -28,10 +35,22 @@ public:
 	// Throws an exception if the source is the same as the destination.
 	void start_working(std::shared_ptr<Structure> source_, std::shared_ptr<Structure> destination_) override;
 
+	// the source may have food again, so try collecting again
+	void wake_up() override;
+	// collecting or depositing, enter the withdrawal or deposit; waiting, enter
+	// the withdrawal we'd make if woken up before our turn
+	void plan_transfer(Ledger& ledger) const override;
+
 	// output information about the current state
 	void describe() const override;
 	// override to allow peasant to tell views amount the amount its carryin
 	void broadcast_current_state() override;
+
+	const char* get_type_name() const override
+		{return "Peasant";}
+	// also saves the working state, the food carried, and the source and destination
+	void save_state(Checkpoint_record& record, const Checkpoint_links& links) const override;
+	void restore_state(const Checkpoint_record& record, const Checkpoint_links& links) override;
 private:
 	enum class Working_State_e { INBOUND, COLLECTING, OUTBOUND, DEPOSITING, NOT_WORKING };
 	Working_State_e working_state;
@@ -41,6 +60,8 @@ private:
 	void stop_working();
 
 	double amount;
+	// true while waiting at the source to be woken up
+	bool asleep;
 	std::shared_ptr<Structure> source;
 	std::shared_ptr<Structure> destination;
 };
@@ -0,0 +1,91 @@
+#include "Profiler.h"
+
+#ifdef PROFILING
+
+#include <algorithm>
+#include <cassert>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <string>
+using namespace std;
+
+// names of the phases, in the order of Phase_e
+static const char* const phase_names_c[] {
+	"movement", "peasant work", "combat", "closest queries", "view updates", "view drawing"
+};
+
+Profiler::Profiler()
+:
+ticks {0},
+phase_totals(int(Phase_e::NUMBER_OF_PHASES))
+{ }
+
+// charge the time so far to the enclosing phase, and start timing this one
+void Profiler::enter(Phase_e phase)
+{
+	Clock::time_point now = Clock::now();
+	if (!open_phases.empty())
+		phase_totals[int(open_phases.back())].time += now - resumed;
+	open_phases.push_back(phase);
+	++phase_totals[int(phase)].calls;
+	resumed = now;
+}
+
+// charge the time so far to this phase, and resume timing the enclosing one
+void Profiler::leave()
+{
+	assert(!open_phases.empty());
+	Clock::time_point now = Clock::now();
+	phase_totals[int(open_phases.back())].time += now - resumed;
+	open_phases.pop_back();
+	resumed = now;
+}
+
+void Profiler::record_update(const char* type, Clock::duration time)
+{
+	Totals& totals = type_totals[type];
+	++totals.calls;
+	totals.time += time;
+}
+
+// print the total time and calls, and the average time per call, for each phase and type
+void Profiler::describe(ostream& os) const
+{
+	auto print_line = [&os](const string& name, const Totals& totals) {
+		double ms = chrono::duration<double, milli>(totals.time).count();
+		double us_per_call = totals.calls ? ms * 1000. / totals.calls : 0.;
+		os << "   " << left << setw(16) << name << right << setw(12) << totals.calls
+			<< setw(12) << ms << setw(12) << us_per_call << '\n';
+	};
+	auto print_heading = [&os](const string& name) {
+		os << left << setw(19) << name << right << setw(12) << "calls"
+			<< setw(12) << "total ms" << setw(12) << "us/call\n";
+	};
+
+	os << "Profile of " << ticks << " ticks\n";
+	print_heading("Phase");
+	for (int i = 0; i < int(Phase_e::NUMBER_OF_PHASES); ++i)
+		print_line(phase_names_c[i], phase_totals[i]);
+	// the same type may have been recorded under more than one copy of its name
+	map<string, Totals> by_type;
+	for (auto& entry : type_totals) {
+		Totals& totals = by_type[entry.first];
+		totals.calls += entry.second.calls;
+		totals.time += entry.second.time;
+	}
+	print_heading("Updates by type");
+	for (auto& entry : by_type)
+		print_line(entry.first, entry.second);
+}
+
+// start over; any phases still open carry on
+void Profiler::clear()
+{
+	ticks = 0;
+	phase_totals.assign(int(Phase_e::NUMBER_OF_PHASES), Totals());
+	type_totals.clear();
+	resumed = Clock::now();
+}
+
+#endif
@@ -0,0 +1,100 @@
+#ifndef PROFILER_H
+#define PROFILER_H
+/*
+Profiler accumulates where a Model's ticks spend their time. It keeps two tables:
+	the time and number of calls of each phase of the work of a tick - stepping
+	the movement, the Peasants' work, the Warriors' combat, the closest-object
+	queries, and sending changes to and drawing the Views;
+	the time and number of updates of each type of Sim_object.
+Phases nest (e.g. an Archer's combat asks for the closest agent), and each phase
+is charged only for the time not spent in the phases nested inside it, so the
+phase times add up to no more than the total. The times per type include
+everything the object's update does.
+
+The Profiler is compiled in only when PROFILING is defined; the Makefile defines
+it unless told otherwise. Code is instrumented with the PROFILE_PHASE and
+PROFILE_UPDATE macros, which declare a timer for the rest of the enclosing
+scope, and which expand to nothing when PROFILING isn't defined.
+Only the thread running the Model's tick may use its Profiler.
+*/
+
+#ifdef PROFILING
+
+#include <chrono>
+#include <iosfwd>
+#include <unordered_map>
+#include <vector>
+
+class Profiler {
+public:
+	enum class Phase_e { MOVEMENT, PEASANT_WORK, COMBAT, CLOSEST_QUERIES, VIEW_UPDATES, VIEW_DRAWING, NUMBER_OF_PHASES };
+
+	Profiler();
+
+	// a phase has started or ended; phases must end in the reverse order they started
+	void enter(Phase_e phase);
+	void leave();
+	// an object of this type has been updated; type must be a string literal
+	void record_update(const char* type, std::chrono::steady_clock::duration time);
+	// count a tick, or several
+	void record_tick(int count = 1)
+		{ticks += count;}
+
+	// print the tables
+	void describe(std::ostream& os) const;
+	// start over
+	void clear();
+
+private:
+	using Clock = std::chrono::steady_clock;
+	struct Totals {
+		long long calls = 0;
+		Clock::duration time = Clock::duration::zero();
+	};
+
+	int ticks;
+	std::vector<Totals> phase_totals;
+	std::unordered_map<const char*, Totals> type_totals;
+	// the phases that have started and not yet ended, innermost last
+	std::vector<Phase_e> open_phases;
+	// when the innermost phase was last started or resumed
+	Clock::time_point resumed;
+};
+
+// times a phase from its construction to its destruction
+class Phase_timer {
+public:
+	Phase_timer(Profiler& profiler_, Profiler::Phase_e phase) : profiler(profiler_)
+		{profiler.enter(phase);}
+	~Phase_timer()
+		{profiler.leave();}
+private:
+	Profiler& profiler;
+};
+
+// times an object's update from its construction to its destruction
+class Update_timer {
+public:
+	Update_timer(Profiler& profiler_, const char* type_) :
+		profiler(profiler_), type(type_), start(std::chrono::steady_clock::now()) {}
+	~Update_timer()
+		{profiler.record_update(type, std::chrono::steady_clock::now() - start);}
+private:
+	Profiler& profiler;
+	const char* type;
+	std::chrono::steady_clock::time_point start;
+};
+
+// time the rest of the scope as the named phase of model's profile
+#define PROFILE_PHASE(model, phase) Phase_timer profile_phase_timer((model).get_profiler(), Profiler::Phase_e::phase)
+// time the rest of the scope as an update of object, in model's profile
+#define PROFILE_UPDATE(model, object) Update_timer profile_update_timer((model).get_profiler(), (object).get_type_name())
+
+#else
+
+#define PROFILE_PHASE(model, phase)
+#define PROFILE_UPDATE(model, object)
+
+#endif
+
+#endif
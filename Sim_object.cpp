@@ -1,7 +1,21 @@
 #include "Sim_object.h"
+#include "Model.h"
+
+#include <cassert>
 using namespace std;
 
 Sim_object::Sim_object(const string& name_)
 :
-name {name_}
-{ }
\ No newline at end of file
+name {name_},
+model {nullptr},
+id {-1},
+symbol {-1}
+{ }
+
+// the Model we belong to; with several Models there's no telling which one an object
+// that hasn't been added to one belongs to, so it mustn't ask
+Model& Sim_object::get_model() const
+{
+	assert(model);
+	return *model;
+}
\ No newline at end of file
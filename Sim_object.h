@@ -3,10 +3,19 @@
 
 /* The Sim_object class provides the interface for all of simulation objects. 
 It also stores the object's name, and has pure virtual accessor functions for 
-the object's position and other information. */
+the object's position and other information. 
+Once the object is added to a Model, it also knows which Model that is, its ID in
+the Model's entity store, and the symbol its name was interned as, which is what
+it identifies itself with when notifying the Views. An object must be added to
+a Model before it uses one; it has no Model to fall back on until then.
+Each kind of object also knows its type name, and how to save its state into a
+Checkpoint_record and restore it from one. */
 #include <string>
-// forward declare Point
+// forward declarations
 class Point;
+class Model;
+struct Checkpoint_record;
+class Checkpoint_links;
 
 class Sim_object {
 public:
@@ -14,15 +23,51 @@ public:
 	
 	const std::string& get_name() const
 		{return name;}
+	// the Model we belong to, set by Model when the object is added; not to be called before
+	Model& get_model() const;
+	virtual void set_model(Model* model_)
+		{model = model_;}
+	// our ID in Model's entity store, set by Model when the object is added
+	int get_id() const
+		{return id;}
+	void set_id(int id_)
+		{id = id_;}
+	// the interned symbol for our name, set by Model when the object is added
+	int get_symbol() const
+		{return symbol;}
+	void set_symbol(int symbol_)
+		{symbol = symbol_;}
 			
 	// ask model to notify views of current state
     virtual void broadcast_current_state() {}
 	virtual Point get_location() const = 0;
 	virtual void describe() const = 0;
 	virtual void update() = 0;
+	// would update do anything? Model updates only the objects that have pending work,
+	// and the objects have to tell it (Model::activate) when they get some
+	virtual bool has_pending_work() const = 0;
+	// How many of the next ticks, up to ticks, could be skipped over with fast_forward:
+	// those in which update would do nothing but move or produce, without touching or
+	// looking at any other object. By default, none.
+	virtual int get_skippable_ticks(int ticks) const
+		{return 0;}
+	// do what that many updates would, in one go; returns the number of the update
+	// (1 is the next) in which the object arrived somewhere, or 0 if it didn't
+	virtual int fast_forward(int ticks)
+		{return 0;}
+
+	// the type of the object, as the factories know it
+	virtual const char* get_type_name() const = 0;
+	// write our state into a checkpoint record, and set it back from one;
+	// links gives the record numbers of the other objects we refer to
+	virtual void save_state(Checkpoint_record& record, const Checkpoint_links& links) const {}
+	virtual void restore_state(const Checkpoint_record& record, const Checkpoint_links& links) {}
 
 private:
 	std::string name;
+	Model* model;
+	int id;
+	int symbol;
 };
 
 #endif
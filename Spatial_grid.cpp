@@ -0,0 +1,114 @@
+#include "Spatial_grid.h"
+
+#include <algorithm>
+#include <cassert>
+#include <climits>
+#include <cmath>
+using namespace std;
+
+Spatial_grid::Spatial_grid(double cell_size_)
+:
+cell_size {cell_size_},
+min_x {INT_MAX}, max_x {INT_MIN}, min_y {INT_MAX}, max_y {INT_MIN},
+count {0}
+{ }
+
+// add id at location; assumes id is not already present
+void Spatial_grid::insert(int id, Point location)
+{
+	if (id >= int(items.size()))
+		items.resize(id + 1, Item{Point(), Cell_key{0, 0}, false});
+	assert(!items[id].present);
+	Cell_key key = cell_of(location);
+	items[id] = Item{location, key, true};
+	add_to_cell(id, key);
+	++count;
+}
+
+// move id to a new location, changing cells only if it has to
+void Spatial_grid::move(int id, Point location)
+{
+	assert(contains(id));
+	Item& item = items[id];
+	item.location = location;
+	Cell_key key = cell_of(location);
+	if (key == item.cell)
+		return;
+	remove_from_cell(id, item.cell);
+	add_to_cell(id, key);
+	item.cell = key;
+}
+
+// remove id; no error if not present
+void Spatial_grid::erase(int id)
+{
+	if (!contains(id))
+		return;
+	remove_from_cell(id, items[id].cell);
+	items[id].present = false;
+	--count;
+}
+
+// remove every id, and forget where they have been
+void Spatial_grid::clear()
+{
+	items.clear();
+	cells.clear();
+	min_x = min_y = INT_MAX;
+	max_x = max_y = INT_MIN;
+	count = 0;
+}
+
+// return all ids no further than radius from center, in no particular order
+vector<int> Spatial_grid::within(Point center, double radius) const
+{
+	vector<int> result;
+	if (count == 0 || radius < 0.)
+		return result;
+	// only look at the cells that overlap both the circle's bounding box and the occupied area
+	Cell_key low = cell_of(Point(center.x - radius, center.y - radius));
+	Cell_key high = cell_of(Point(center.x + radius, center.y + radius));
+	for (int x = max(low.x, min_x); x <= min(high.x, max_x); ++x) {
+		for (int y = max(low.y, min_y); y <= min(high.y, max_y); ++y) {
+			auto cell = cells.find(Cell_key{x, y});
+			if (cell == cells.end())
+				continue;
+			for (int id : cell->second) {
+				if (cartesian_distance(center, items[id].location) <= radius)
+					result.push_back(id);
+			}
+		}
+	}
+	return result;
+}
+
+Spatial_grid::Cell_key Spatial_grid::cell_of(Point location) const
+{
+	// clamp so that far away points can't overflow the cell coordinates
+	const double limit_c = INT_MAX / 2;
+	double x = max(-limit_c, min(limit_c, floor(location.x / cell_size)));
+	double y = max(-limit_c, min(limit_c, floor(location.y / cell_size)));
+	return Cell_key{int(x), int(y)};
+}
+
+void Spatial_grid::add_to_cell(int id, Cell_key key)
+{
+	cells[key].push_back(id);
+	min_x = min(min_x, key.x);
+	max_x = max(max_x, key.x);
+	min_y = min(min_y, key.y);
+	max_y = max(max_y, key.y);
+}
+
+void Spatial_grid::remove_from_cell(int id, Cell_key key)
+{
+	auto cell = cells.find(key);
+	assert(cell != cells.end());
+	vector<int>& ids = cell->second;
+	auto itr = find(ids.begin(), ids.end(), id);
+	assert(itr != ids.end());
+	*itr = ids.back();
+	ids.pop_back();
+	if (ids.empty())
+		cells.erase(cell);
+}
@@ -0,0 +1,141 @@
+#ifndef SPATIAL_GRID_H
+#define SPATIAL_GRID_H
+/*
+Spatial_grid is a uniform hash grid over the plane that Model uses to find Agents
+by location without looking at every Agent. Items are integer IDs (Model uses
+Entity_store IDs); the plane is cut into square cells of a fixed size, and only
+the cells that currently hold items are stored, in a hash table keyed by cell.
+
+nearest() searches outward from the cell holding the query point, one square ring
+of cells at a time, and stops as soon as no unsearched cell can hold anything
+closer than the best item found. The bounding box it searches within never
+shrinks, so once the rings searched so far cover more cells than there are items,
+e.g. when a few items are far apart, it looks at every item instead; a query then
+costs no more than a linear scan. Only the items a caller-supplied test accepts
+are candidates. Ties in distance are broken by a caller-supplied ordering, so the
+result is the same as a linear scan in that order.
+*/
+#include "Geometry.h"
+
+#include <algorithm>
+#include <unordered_map>
+#include <vector>
+
+class Spatial_grid {
+public:
+	// returned by nearest if there's nothing to find
+	static const int no_id_c = -1;
+
+	Spatial_grid(double cell_size_);
+
+	// add id at location; assumes id is not already present
+	void insert(int id, Point location);
+	// move id to a new location
+	void move(int id, Point location);
+	// remove id; no error if not present
+	void erase(int id);
+	// remove every id
+	void clear();
+	bool contains(int id) const
+		{return id < int(items.size()) && items[id].present;}
+
+	// return the id closest to location out of those for which is_candidate(id) is true,
+	// or no_id_c if there is none. If several are equally close, the one that comes
+	// first according to comes_before(lhs, rhs) wins.
+	template<typename Test, typename Ordering>
+	int nearest(Point location, Test is_candidate, Ordering comes_before) const;
+	// return all ids no further than radius from center, in no particular order
+	std::vector<int> within(Point center, double radius) const;
+
+private:
+	struct Cell_key {
+		int x;
+		int y;
+		bool operator== (const Cell_key& rhs) const
+			{return x == rhs.x && y == rhs.y;}
+	};
+	struct Cell_hash {
+		size_t operator() (const Cell_key& key) const
+			{return size_t(key.x) * 73856093u ^ size_t(key.y) * 19349663u;}
+	};
+	struct Item {
+		Point location;
+		Cell_key cell;
+		bool present;
+	};
+
+	double cell_size;
+	std::vector<Item> items;	// by id
+	std::unordered_map<Cell_key, std::vector<int>, Cell_hash> cells;
+	// bounding box of every cell that has ever been occupied
+	int min_x, max_x, min_y, max_y;
+	int count;
+
+	Cell_key cell_of(Point location) const;
+	void add_to_cell(int id, Cell_key key);
+	void remove_from_cell(int id, Cell_key key);
+};
+
+// Examine the cells in rings of increasing radius around the query cell.
+// Everything in ring r + 1 or further out is at least r * cell_size away, so once
+// the best distance so far is below that, nothing further out can beat it or tie it.
+// The same id wins whether it is found in the rings or in the scan of every item.
+template<typename Test, typename Ordering>
+int Spatial_grid::nearest(Point location, Test is_candidate, Ordering comes_before) const
+{
+	// allow for rounding in the cell and distance calculations
+	const double slack_c = 1e-9;
+	int best = no_id_c;
+	double best_distance = 0.;
+	if (count == 0)
+		return best;
+
+	auto consider = [&](int id) {
+		if (!is_candidate(id))
+			return;
+		double distance = cartesian_distance(location, items[id].location);
+		if (best == no_id_c || distance < best_distance ||
+			(distance == best_distance && comes_before(id, best))) {
+			best = id;
+			best_distance = distance;
+		}
+	};
+
+	Cell_key center = cell_of(location);
+	int max_ring = 0;
+	max_ring = std::max(max_ring, center.x - min_x);
+	max_ring = std::max(max_ring, max_x - center.x);
+	max_ring = std::max(max_ring, center.y - min_y);
+	max_ring = std::max(max_ring, max_y - center.y);
+
+	for (int ring = 0; ring <= max_ring; ++ring) {
+		if (best != no_id_c && best_distance < (ring - 1) * cell_size * (1. - slack_c))
+			break;
+		// the rings out to this one hold more cells than there are items, so scanning
+		// the items is cheaper than going on; start again, since it covers them all
+		long long side = 2LL * ring + 1;
+		if (side * side > count) {
+			best = no_id_c;
+			for (int id = 0; id < int(items.size()); ++id) {
+				if (items[id].present)
+					consider(id);
+			}
+			return best;
+		}
+		for (int x = center.x - ring; x <= center.x + ring; ++x) {
+			// in the first and last columns of the ring visit every cell, otherwise just the two ends
+			bool full_column = (x == center.x - ring || x == center.x + ring);
+			int step = full_column ? 1 : 2 * ring;
+			for (int y = center.y - ring; y <= center.y + ring; y += step) {
+				auto cell = cells.find(Cell_key{x, y});
+				if (cell == cells.end())
+					continue;
+				for (int id : cell->second)
+					consider(id);
+			}
+		}
+	}
+	return best;
+}
+
+#endif
@@ -1,6 +1,8 @@
 #include "Structure.h"
+#include "Agent.h"
+#include "Ledger.h"
 #include "Model.h"
-#include <iostream>
+#include "Output.h"
 using namespace std;
 
 Structure::Structure(std::string name_, Point location_)
@@ -14,10 +16,75 @@ Structure::~Structure()
 
 void Structure::describe() const
 {
-	cout << Sim_object::get_name() << " at " << location << endl;
+	Output::events() << Sim_object::get_name() << " at " << location << '\n';
 }
 
 void Structure::broadcast_current_state()
 {
-	Model::get_Model().notify_location(get_name(), location);
+	get_model().notify_location(get_symbol(), location);
+}
+
+bool Structure::add_waiter(shared_ptr<Agent> waiter)
+{
+	waiters.push_back(waiter);
+	return true;
+}
+
+// waking up may make an Agent wait here again, so start a new list first
+void Structure::wake_waiters()
+{
+	vector<weak_ptr<Agent>> woken;
+	woken.swap(waiters);
+	for (weak_ptr<Agent>& waiter : woken) {
+		shared_ptr<Agent> agent = waiter.lock();
+		if (agent)
+			agent->wake_up();
+	}
+}
+
+void Structure::settle(vector<Transfer>& transfers, int time)
+{
+	keep_state();
+	make_transfers(transfers, time);
+}
+
+void Structure::resettle(vector<Transfer>& transfers, int time)
+{
+	restore_kept_state();
+	make_transfers(transfers, time);
+}
+
+// A withdrawal by an Agent whose turn comes before ours sees us as of last tick.
+// A standby withdrawal is made only after a deposit that will wake the waiters up;
+// the depositor wakes them up at its turn.
+void Structure::make_transfers(vector<Transfer>& transfers, int time)
+{
+	bool turn_reached = false;
+	bool woken = false;
+	for (Transfer& transfer : transfers) {
+		if (transfer.after_structure && !turn_reached) {
+			reach_turn(time);
+			turn_reached = true;
+		}
+		transfer.made = !transfer.standby || woken;
+		if (!transfer.made)
+			continue;
+		if (transfer.deposit) {
+			transfer.wakes_waiters = put(transfer.amount);
+			woken = woken || transfer.wakes_waiters;
+		} else {
+			transfer.result = take(transfer.amount, transfer.after_structure ? time : time - 1);
+		}
+	}
+	if (!turn_reached)
+		reach_turn(time);
+}
+
+void Structure::plan_waiters(Ledger& ledger) const
+{
+	for (const weak_ptr<Agent>& waiter : waiters) {
+		shared_ptr<Agent> agent = waiter.lock();
+		if (agent)
+			agent->plan_transfer(ledger);
+	}
 }
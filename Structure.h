@@ -1,10 +1,21 @@
 #ifndef STRUCTURE_H
 #define STRUCTURE_H
 
-/* A Structure is a Sim_object with a location and interface to derived types */
+/* A Structure is a Sim_object with a location and interface to derived types.
+An Agent that finds nothing to withdraw can wait at a Structure instead of trying
+again on every tick; the Structure wakes its waiters up (Agent::wake_up), in the
+order they started waiting, when there may be something to withdraw again.
+In a parallel update, a Structure makes a whole tick's worth of transfers at once
+(settle); see Ledger.h. */
 #include "Sim_object.h"
 #include "Geometry.h"
+#include <memory>
 #include <string>
+#include <vector>
+
+struct Agent;
+class Ledger;
+struct Transfer;
 
 class Structure : public Sim_object {
 public:
@@ -16,6 +27,15 @@ public:
 	{return location;}
 
 	void update(){/*noop*/};
+	// a plain Structure has nothing to do
+	bool has_pending_work() const override
+		{return false;}
+	// updating does nothing, so any number of ticks can be skipped
+	int get_skippable_ticks(int ticks) const override
+		{return ticks;}
+	// bring whatever state is kept up to date only when needed up to date,
+	// and tell the Views if it has changed; Model does this before drawing the Views
+	virtual void catch_up() {}
 
 	// output information about the current state
 	virtual void describe() const;
@@ -28,9 +48,45 @@ public:
 	{return 0.0;}
 	virtual void deposit(double amount_to_give)
 	{}
+	// Wait here until there may be something to withdraw; returns false if there's no need,
+	// since there will be something by the waiter's next update. A plain Structure never has
+	// anything, so its waiters are never woken up.
+	virtual bool add_waiter(std::shared_ptr<Agent> waiter);
+	// tell the Views the amount on hand, if there is one
+	virtual void notify_amount() {}
+
+	// wake up everyone waiting here; deposit does this, or the depositor, when its
+	// deposit has been settled ahead of time
+	void wake_waiters();
+
+	// make this tick's transfers, in alphabetical order of the Agents, as they would
+	// be made at each Agent's turn; touches nothing but this Structure
+	void settle(std::vector<Transfer>& transfers, int time);
+	// go back to how this Structure was before settling, and settle again
+	void resettle(std::vector<Transfer>& transfers, int time);
+	// have the Agents waiting here enter the withdrawals they'd make if woken up
+	void plan_waiters(Ledger& ledger) const;
+
+protected:
+	// the work of withdraw and deposit, without telling the Views or waking anyone up;
+	// touch nothing but this Structure
+	// take out up to request, as of the end of tick time_updated, and return how much
+	virtual double take(double request, int time_updated)
+		{return 0.0;}
+	// add in amount, and return true if that leaves enough to wake the waiters up
+	virtual bool put(double amount)
+		{return false;}
+	// settling has reached the point in the tick where this Structure is updated
+	virtual void reach_turn(int time) {}
+	// keep whatever settling changes, and go back to it
+	virtual void keep_state() {}
+	virtual void restore_kept_state() {}
 
 private:
 	Point location;
+	std::vector<std::weak_ptr<Agent>> waiters;
+
+	void make_transfers(std::vector<Transfer>& transfers, int time);
 };
 
 #endif
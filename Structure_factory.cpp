@@ -1,4 +1,5 @@
 #include "Structure_factory.h"
+#include "Object_pool.h"
 #include "Town_Hall.h"
 #include "Farm.h"
 #include "Utility.h"
@@ -11,9 +12,9 @@ shared_ptr<Structure> create_structure(const string& name, const string& type, P
 {
 	if (type == "Farm") {
 		// make Farm
-		return shared_ptr<Structure>(new Farm(name, location));
+		return allocate_shared<Farm>(Pool_allocator<Farm>(), name, location);
 	} else if (type == "Town_Hall") {
-		return shared_ptr<Structure>(new Town_Hall(name, location));
+		return allocate_shared<Town_Hall>(Pool_allocator<Town_Hall>(), name, location);
 		// make Town_Hall
 	} else {
 		throw Error(unknown_type);
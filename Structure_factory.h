@@ -10,7 +10,8 @@ struct Structure;
 
 // Create and return the pointer to the specified Structure type. If the type
 // is unrecognized, throws Error("Trying to create structure of unknown type!")
-// The Structure is allocated with new, so some other component is resposible for deleting it.
+// The Structure and its shared_ptr control block are allocated together from a pool
+// for its type, and go back to the pool when the last shared_ptr to it is gone.
 std::shared_ptr<Structure> create_structure(const std::string& name, const std::string& type, Point location);
 
 #endif
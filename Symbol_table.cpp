@@ -0,0 +1,22 @@
+#include "Symbol_table.h"
+using namespace std;
+
+// return the symbol for name, adding it to the table if it isn't there yet
+int Symbol_table::intern(const string& name)
+{
+	auto itr = symbols.find(name);
+	if (itr != symbols.end())
+		return itr->second;
+	int symbol = int(names.size());
+	names.push_back(name);
+	type_names.push_back("");
+	symbols.insert(make_pair(name, symbol));
+	return symbol;
+}
+
+// return the symbol for name, or no_symbol_c if it has never been interned
+int Symbol_table::find(const string& name) const
+{
+	auto itr = symbols.find(name);
+	return itr == symbols.end() ? no_symbol_c : itr->second;
+}
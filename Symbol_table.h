@@ -0,0 +1,110 @@
+#ifndef SYMBOL_TABLE_H
+#define SYMBOL_TABLE_H
+/*
+Symbol_table interns object names: each distinct name is given a small integer
+symbol the first time it is seen, and keeps that symbol for as long as the table
+lives, even if the object is removed and a new one later takes the same name.
+Model and the Views pass symbols around instead of strings, and only turn a
+symbol back into its name when something has to be printed. The table also
+remembers the type of the object that last had each name.
+
+Symbol_map is a dense map from symbols to values that the Views use to keep their state.
+Setting, finding and erasing an entry are constant time, and the entries are stored
+contiguously, but in no particular order.
+*/
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+class Symbol_table {
+public:
+	// value used for "no symbol"
+	static const int no_symbol_c = -1;
+
+	// return the symbol for name, adding it to the table if it isn't there yet
+	int intern(const std::string& name);
+	// return the symbol for name, or no_symbol_c if it has never been interned
+	int find(const std::string& name) const;
+	// return the name the symbol stands for
+	const std::string& get_name(int symbol) const
+		{return names[symbol];}
+	// number of symbols handed out so far
+	int size() const
+		{return int(names.size());}
+	// the type of the object that last had the name the symbol stands for, e.g. "Peasant",
+	// or "" if none has been given; type_name must last as long as the table, as a literal does
+	const char* get_type_name(int symbol) const
+		{return type_names[symbol];}
+	void set_type_name(int symbol, const char* type_name)
+		{type_names[symbol] = type_name;}
+
+private:
+	std::unordered_map<std::string, int> symbols;
+	std::vector<std::string> names;
+	std::vector<const char*> type_names;
+};
+
+template<typename T>
+class Symbol_map {
+public:
+	// save the value for symbol, replacing the previous one if present
+	void set(int symbol, const T& value)
+	{
+		if (symbol >= int(position.size()))
+			position.resize(symbol + 1, absent_c);
+		if (position[symbol] == absent_c) {
+			position[symbol] = int(keys.size());
+			keys.push_back(symbol);
+			values.push_back(value);
+		} else {
+			values[position[symbol]] = value;
+		}
+	}
+	// return a pointer to the value for symbol, or nullptr if not present
+	T* find(int symbol)
+	{
+		if (symbol < 0 || symbol >= int(position.size()) || position[symbol] == absent_c)
+			return nullptr;
+		return &values[position[symbol]];
+	}
+	const T* find(int symbol) const
+		{return const_cast<Symbol_map*>(this)->find(symbol);}
+	bool contains(int symbol) const
+		{return symbol >= 0 && symbol < int(position.size()) && position[symbol] != absent_c;}
+	// remove the entry for symbol; no error if it isn't present
+	void erase(int symbol)
+	{
+		if (!contains(symbol))
+			return;
+		// move the last entry into the hole
+		int hole = position[symbol];
+		keys[hole] = keys.back();
+		values[hole] = values.back();
+		position[keys[hole]] = hole;
+		keys.pop_back();
+		values.pop_back();
+		position[symbol] = absent_c;
+	}
+	void clear()
+	{
+		position.clear();
+		keys.clear();
+		values.clear();
+	}
+
+	// entries are numbered 0 to size() - 1, in no particular order
+	int size() const
+		{return int(keys.size());}
+	int symbol_at(int i) const
+		{return keys[i];}
+	const T& value_at(int i) const
+		{return values[i];}
+
+private:
+	enum { absent_c = -1 };
+	std::vector<int> position;	// index into keys and values, by symbol
+	std::vector<int> keys;
+	std::vector<T> values;
+};
+
+#endif
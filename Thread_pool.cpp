@@ -0,0 +1,106 @@
+#include "Thread_pool.h"
+using namespace std;
+
+// start a pool that runs work on thread_count threads in total
+Thread_pool::Thread_pool(int thread_count_)
+:
+job {nullptr},
+job_size {0},
+generation {0},
+chunks_left {0},
+quitting {false}
+{
+	for (int i = 1; i < thread_count_; ++i)
+		workers.push_back(thread(&Thread_pool::worker_loop, this, i));
+}
+
+// tells the workers to quit, and waits for them
+Thread_pool::~Thread_pool()
+{
+	{
+		lock_guard<mutex> lock(mtx);
+		quitting = true;
+	}
+	work_ready.notify_all();
+	for (auto& worker : workers)
+		worker.join();
+}
+
+// call fn(begin, end) on disjoint chunks that together cover [0, n), one chunk per thread,
+// and wait until they have all returned
+void Thread_pool::parallel_for(int n, const function<void(int, int)>& fn)
+{
+	if (workers.empty() || n <= 1) {
+		fn(0, n);
+		return;
+	}
+	{
+		lock_guard<mutex> lock(mtx);
+		job = &fn;
+		job_size = n;
+		chunks_left = int(workers.size());
+		job_error = nullptr;
+		++generation;
+	}
+	work_ready.notify_all();
+
+	// do our own share while the workers do theirs; fn has to outlive their use
+	// of it, so wait for them even if it throws
+	run_chunk(fn, 0);
+
+	exception_ptr error;
+	{
+		unique_lock<mutex> lock(mtx);
+		work_done.wait(lock, [this] {return chunks_left == 0;});
+		job = nullptr;
+		error = job_error;
+		job_error = nullptr;
+	}
+	if (error)
+		rethrow_exception(error);
+}
+
+void Thread_pool::run_chunk(const function<void(int, int)>& fn, int chunk_number)
+{
+	int begin, end;
+	chunk_range(chunk_number, begin, end);
+	if (begin >= end)
+		return;
+	try {
+		fn(begin, end);
+	} catch (...) {
+		lock_guard<mutex> lock(mtx);
+		if (!job_error)
+			job_error = current_exception();
+	}
+}
+
+void Thread_pool::worker_loop(int worker_number)
+{
+	int seen_generation = 0;
+	while (true) {
+		const function<void(int, int)>* current_job;
+		{
+			unique_lock<mutex> lock(mtx);
+			work_ready.wait(lock, [this, seen_generation] {return quitting || generation != seen_generation;});
+			if (quitting)
+				return;
+			seen_generation = generation;
+			current_job = job;
+		}
+		run_chunk(*current_job, worker_number);
+		{
+			lock_guard<mutex> lock(mtx);
+			--chunks_left;
+		}
+		work_done.notify_one();
+	}
+}
+
+// the range of the chunk for thread chunk_number (0 is the calling thread)
+void Thread_pool::chunk_range(int chunk_number, int& begin, int& end) const
+{
+	int chunks = get_thread_count();
+	begin = int(long(job_size) * chunk_number / chunks);
+	end = int(long(job_size) * (chunk_number + 1) / chunks);
+}
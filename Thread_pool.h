@@ -0,0 +1,61 @@
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+/*
+Thread_pool is a fixed set of worker threads that Model uses to run the
+independent part of a tick in parallel. parallel_for cuts a range of indices
+into one contiguous chunk per thread, runs the supplied function on every chunk,
+and returns only when all of them are done. The calling thread works on the first
+chunk itself, so a pool of n threads starts n - 1 workers.
+If the function throws on any thread, the other chunks still run to the end, and
+then the first exception thrown is rethrown on the calling thread.
+*/
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+class Thread_pool {
+public:
+	// start a pool that runs work on thread_count threads in total
+	Thread_pool(int thread_count_);
+	// tells the workers to quit, and waits for them
+	~Thread_pool();
+
+	int get_thread_count() const
+		{return int(workers.size()) + 1;}
+
+	// call fn(begin, end) on disjoint chunks that together cover [0, n), one chunk per thread,
+	// and wait until they have all returned; rethrows the first exception fn threw, if any
+	void parallel_for(int n, const std::function<void(int, int)>& fn);
+
+private:
+	std::vector<std::thread> workers;
+	std::mutex mtx;
+	std::condition_variable work_ready;
+	std::condition_variable work_done;
+
+	// the current job; generation counts jobs so workers can tell a new one has arrived
+	const std::function<void(int, int)>* job;
+	int job_size;
+	int generation;
+	int chunks_left;
+	// the first exception the current job threw, on whichever thread
+	std::exception_ptr job_error;
+	bool quitting;
+
+	void worker_loop(int worker_number);
+	// run the job on one chunk, keeping what it throws if nothing has been thrown yet
+	void run_chunk(const std::function<void(int, int)>& fn, int chunk_number);
+	// the range of the chunk for thread chunk_number (0 is the calling thread)
+	void chunk_range(int chunk_number, int& begin, int& end) const;
+
+	// disallow copy/move construction or assignment
+	Thread_pool(const Thread_pool&) = delete;
+	Thread_pool& operator= (const Thread_pool&)  = delete;
+	Thread_pool(Thread_pool&&) = delete;
+	Thread_pool& operator= (Thread_pool&&) = delete;
+};
+
+#endif
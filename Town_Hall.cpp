@@ -1,12 +1,17 @@
 #include "Town_Hall.h"
+#include "Checkpoint.h"
 #include "Model.h"
-#include <iostream>
+#include "Output.h"
 using namespace std;
 
+// less than this isn't supplied
+static const double min_withdrawal_c {1.0};
+
 Town_Hall::Town_Hall(const string& name_, Point location_)
 :
 Structure(name_, location_),
-amount {0}
+amount {0},
+kept_amount {0}
 { }
 
 Town_Hall::~Town_Hall()
@@ -14,33 +19,62 @@ Town_Hall::~Town_Hall()
 
 void Town_Hall::deposit(double deposit_amount)
 {
-	amount += deposit_amount;
-	Model::get_Model().notify_amount(get_name(), amount);
+	bool wake = put(deposit_amount);
+	notify_amount();
+	if (wake)
+		wake_waiters();
 }
 
 double Town_Hall::withdraw(double amount_to_obtain)
 {
-	double amount_available = amount * .9;
-	if (amount_available < 1.0)
-		amount_to_obtain = 0;
-	else if (amount_available < amount_to_obtain)
-		amount_to_obtain = amount_available;
-
-	amount -= amount_to_obtain;
-	Model::get_Model().notify_amount(get_name(), amount);
+	amount_to_obtain = take(amount_to_obtain, get_model().get_time_updated(get_id()));
+	notify_amount();
 	return amount_to_obtain;
+}
 
+bool Town_Hall::put(double amount_to_put)
+{
+	amount += amount_to_put;
+	return get_amount_available() >= min_withdrawal_c;
+}
+
+// the amount on hand doesn't change by itself, so time_updated makes no difference
+double Town_Hall::take(double request, int time_updated)
+{
+	double amount_available = get_amount_available();
+	if (amount_available < min_withdrawal_c)
+		request = 0;
+	else if (amount_available < request)
+		request = amount_available;
+
+	amount -= request;
+	return request;
+}
+
+void Town_Hall::notify_amount()
+{
+	get_model().notify_amount(get_symbol(), amount);
 }
 
 void Town_Hall::describe() const
 {
-	cout << "Town_Hall ";
+	Output::events() << "Town_Hall ";
 	Structure::describe();
-	cout << "   Contains " << amount << endl;
+	Output::events() << "   Contains " << amount << '\n';
 }
 
 void Town_Hall::broadcast_current_state()
 {
-	Model::get_Model().notify_amount(get_name(), amount);
+	notify_amount();
 	Structure::broadcast_current_state();
+}
+
+void Town_Hall::save_state(Checkpoint_record& record, const Checkpoint_links& links) const
+{
+	record.amount = amount;
+}
+
+void Town_Hall::restore_state(const Checkpoint_record& record, const Checkpoint_links& links)
+{
+	amount = record.amount;
 }
\ No newline at end of file
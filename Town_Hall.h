@@ -2,7 +2,8 @@
 #define TOWN_HALL_H
 /* 
 A Town_Hall is a structure that provides for depositing and withdrawing food,
-but does no updating.
+but does no updating. Its waiters are woken up by a deposit that leaves enough
+on hand to withdraw some.
 */
 #include "Structure.h"
 #include <string>
@@ -19,14 +20,33 @@ public:
 	// but amounts less than 1.0 are not supplied - the amount returned is zero.
 	// update the amount on hand by subtracting the amount returned.
 	double withdraw(double amount_to_obtain) override;
+	void notify_amount() override;
 
 	// output information about the current state
 	void describe() const override;
 
 	void broadcast_current_state() override;
+
+	const char* get_type_name() const override
+		{return "Town_Hall";}
+	void save_state(Checkpoint_record& record, const Checkpoint_links& links) const override;
+	void restore_state(const Checkpoint_record& record, const Checkpoint_links& links) override;
+
+protected:
+	double take(double request, int time_updated) override;
+	bool put(double amount_to_put) override;
+	void keep_state() override
+		{kept_amount = amount;}
+	void restore_kept_state() override
+		{amount = kept_amount;}
 	
 private:
 	double amount;
+	double kept_amount;
+
+	// how much withdraw could give, before the minimum
+	double get_amount_available() const
+		{return amount * .9;}
 };
 
 #endif
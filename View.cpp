@@ -6,17 +6,22 @@ using namespace std;
 // therefore we'll give most of View's function an empty implementation
 // provide a fat interface for derived classes
 
-// Save the supplied name and location for future use in a draw() call
-// If the name is already present, the new location replaces the previous one.
-void View::update_location(const string& name, Point location)
+void View::draw_changes()
+{
+	draw();
+}
+
+// Save the supplied symbol and location for future use in a draw() call
+// If the symbol is already present, the new location replaces the previous one.
+void View::update_location(int symbol, Point location)
 { /* provide an empty definition for base classes to override */ }
-// Save the supplied name and amount
-void View::update_amount(const string& name, double amount_)
+// Save the supplied symbol and amount
+void View::update_amount(int symbol, double amount_)
 { /* provide an empty definition for base classes to override */ }
-// Save the supplied name and health
-void View::update_health(const string& name, double health_)
+// Save the supplied symbol and health
+void View::update_health(int symbol, double health_)
 { /* provide an empty definition for base classes to override */ }
-void View::update_remove(const string& name)
+void View::update_remove(int symbol)
 { /* provide an empty definition for base classes to override */ }
 
 void View::set_size(int size_)
@@ -29,4 +34,7 @@ void View::set_defaults()
 { /* provide an empty definition for base classes to override */ }
 // set the origin
 void View::set_origin(Point origin_)
-{ /* provide an empty definition for base classes to override */ }
\ No newline at end of file
+{ /* provide an empty definition for base classes to override */ }
+// choose what a view of values lists
+void View::set_listing(Listing_e listing_, int count_)
+{ /* provide an empty definition for base classes to override */ }
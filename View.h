@@ -11,17 +11,21 @@ public:
 
 	// displays the views information to the user
 	virtual void draw() = 0;
+	// displays only what has changed since the view was last drawn, either way;
+	// a view that doesn't keep track of that draws everything
+	virtual void draw_changes();
 	// tells the view to "forget" all the information it has
 	virtual void clear() = 0;
-	// Save the supplied name and location for future use in a draw() call
-	// If the name is already present, the new location replaces the previous one.
-	virtual void update_location(const std::string& name, Point location);
-	// Save the supplied name and amount
-	virtual void update_amount(const std::string& name, double amount_);
-	// Save the supplied name and health
-	virtual void update_health(const std::string& name, double health_);
-	// Remove the name and its location; no error if the name is not present.
-	virtual void update_remove(const std::string& name);
+	// Objects are identified by the symbol their name was interned as.
+	// Save the supplied symbol and location for future use in a draw() call
+	// If the symbol is already present, the new location replaces the previous one.
+	virtual void update_location(int symbol, Point location);
+	// Save the supplied symbol and amount
+	virtual void update_amount(int symbol, double amount_);
+	// Save the supplied symbol and health
+	virtual void update_health(int symbol, double health_);
+	// Remove the symbol and its location; no error if the symbol is not present.
+	virtual void update_remove(int symbol);
 	// modify the display parameters
 	// if the size is out of bounds will throw Error("New map size is too big!")
 	// or Error("New map size is too small!")
@@ -32,6 +36,11 @@ public:
 	virtual void set_defaults();
 	// set the origin
 	virtual void set_origin(Point origin_);
+
+	// what a view of values lists: every value, a summary of the values of each type of
+	// object, or the summary and the count highest or lowest values
+	enum class Listing_e { ALL, SUMMARY, TOP, BOTTOM };
+	virtual void set_listing(Listing_e listing_, int count_);
 };
 
 #endif
\ No newline at end of file
@@ -1,73 +1,109 @@
 #include "View.h"
 #include "Views.h"
+#include "Output.h"
 #include "Utility.h"
 #include <algorithm>
-#include <iomanip>
-#include <iostream>
-#include <iterator>
-#include <sstream>
+#include <cmath>
+#include <cstdio>
 using namespace std;
 
 // ============================
 // === GRAPH IMPLEMENTATION ===
 // ============================
 
-void Grid::print_grid(vector<vector<string>>& grid, const int& size, const double& scale, const Point& origin)
+// what a cell holds when it isn't just one object
+static const int empty_cell_c {-1};
+static const int crowded_cell_c {-2};
+
+// add a coordinate label to frame, formatted as with setw(4), fixed and setprecision(0)
+static void append_label(string& frame, double label)
+{
+	char buffer[32];
+	int length = snprintf(buffer, sizeof(buffer), "%4.0f", label);
+	frame.append(buffer, length);
+}
+
+void Grid::render_grid(const int& size, const double& scale, const Point& origin)
 {
-	// print the grid
 	const int label_freq_c = 3;
+	const int max_char_c = 2;
+	frame.clear();
 	for (int y = size - 1; y >= 0; --y) {
 		if (y % label_freq_c == 0) {
-			// store the label
-			// int(origin.x) + int(y*scale)
-			double label = origin.y + (y * scale);
-			// save old settings
-			ios::fmtflags old_settings = cout.flags();
-			int old_precision = cout.precision();
-			// actually print the label
-			cout.precision(0);
-			cout << setw(4) << setprecision(0) << fixed << label << " ";
-			// resore old settings
-			cout.precision(old_precision);
-			cout.flags(old_settings);
+			append_label(frame, origin.y + (y * scale));
+			frame += ' ';
 		} else {
-			cout << "     ";
+			frame.append(5, ' ');
 		}
+		const int* row = &cells[y * size];
 		for (int x = 0; x < size; ++x) {
-			cout << grid[y][x];
+			if (row[x] == empty_cell_c)
+				frame.append(". ");
+			else if (row[x] == crowded_cell_c)
+				frame.append("* ");
+			else
+				// the first two chars of the name
+				frame.append(symbols.get_name(object_list.symbol_at(row[x])), 0, max_char_c);
 		}
-		cout << endl;
+		frame += '\n';
 	}
 	// now print labels for the last row
 	for (int x = 0; x < size; x += label_freq_c) {
-		double label = (x * scale) + origin.x;
-		// save old settings
-
-		ios::fmtflags old_settings = cout.flags();
-		int old_precision = cout.precision();
-		// actually print the label
-		cout << "  " << setw(4) << setprecision(0) << fixed << label;
-		// restore old settings
-		cout.precision(old_precision);
-		cout.flags(old_settings);
+		frame.append("  ");
+		append_label(frame, (x * scale) + origin.x);
+	}
+	frame += '\n';
+}
+
+void Grid::print_grid(const int& size, const double& scale, const Point& origin)
+{
+	render_grid(size, scale, origin);
+	Output::events().write(frame.data(), frame.size());
+	drawn_frame.swap(frame);
+}
+
+// compare the rendered rows with those last printed, one line at a time
+const string& Grid::get_changed_rows(const int& size, const double& scale, const Point& origin)
+{
+	render_grid(size, scale, origin);
+	changes.clear();
+	size_t begin = 0;
+	size_t drawn_begin = 0;
+	for (int row = 0; begin < frame.size(); ++row) {
+		size_t end = frame.find('\n', begin) + 1;
+		size_t drawn_end = drawn_begin < drawn_frame.size() ? drawn_frame.find('\n', drawn_begin) + 1 : drawn_begin;
+		if (frame.compare(begin, end - begin, drawn_frame, drawn_begin, drawn_end - drawn_begin) != 0) {
+			changes += "@ ";
+			changes += to_string(row);
+			changes += ' ';
+			changes.append(frame, begin, end - begin);
+		}
+		begin = end;
+		drawn_begin = drawn_end;
 	}
-	cout << endl;
+	drawn_frame.swap(frame);
+	return changes;
 }
 
+Grid::Grid(const Symbol_table& symbols_)
+:
+symbols(symbols_)
+{ }
+
 // Discard the saved information - drawing will show only a empty pattern
 void Grid::clear()
 {
 	object_list.clear();
 }
 
-void Grid::update_location(const string& name, Point location)
+void Grid::update_location(int symbol, Point location)
 {
-	object_list[name] = location;
+	object_list.set(symbol, location);
 }
 
-void Grid::update_remove(const string& name)
+void Grid::update_remove(int symbol)
 {
-	object_list.erase(name);
+	object_list.erase(symbol);
 }
 
 // Calculate the cell subscripts corresponding to the supplied location parameter, 
@@ -94,28 +130,24 @@ bool Grid::get_subscripts(int &ix, int &iy, Point location, const int& size, con
 		return true;
 }
 
-void Grid::populate_grid(vector<vector<string>>& grid, vector<string>& outside, const int &size, const double& scale, const Point& origin)
+void Grid::populate_grid(const int &size, const double& scale, const Point& origin)
 {
+	cells.assign(size * size, empty_cell_c);
+	outside.clear();
 	int ix = 0;
 	int iy = 0;
-	for (auto& i : object_list) {
-		ix = i.second.x;
-		iy = i.second.y;
-		if (!get_subscripts(ix, iy, i.second, size, scale, origin)) {
+	for (int i = 0; i < object_list.size(); ++i) {
+		if (!get_subscripts(ix, iy, object_list.value_at(i), size, scale, origin)) {
 			// isn't present in the grid, need to add it to the outside container
-			auto insert_itr = lower_bound(outside.begin(), outside.end(), i.first);
-			outside.insert(insert_itr, i.first);
+			outside.push_back(&symbols.get_name(object_list.symbol_at(i)));
 		} else {
-			// is in the grid so add it!
-			const int max_char_c = 2;
-			// add the first to chars of the name if its the first name in the cell,
-			// otherwise make it an asterik
-			grid[iy][ix] = (grid[iy][ix] == ". " ? i.first.substr(0, max_char_c) : "* ");
+			// is in the grid so add it! if it's not the first in the cell, make it an asterisk
+			int& cell = cells[iy * size + ix];
+			cell = cell == empty_cell_c ? i : crowded_cell_c;
 		}
 	}
 }
 
-
 // ============================
 // === LOCAL IMPLEMENTATION ===
 // ============================
@@ -123,9 +155,10 @@ void Grid::populate_grid(vector<vector<string>>& grid, vector<string>& outside,
 static const int def_local_size_c {9};
 static const double def_local_scale_c {2};
 
-Local::Local(Point location, string name_)
+Local::Local(Point location, int symbol_, const Symbol_table& symbols_)
 :
-name {name_},
+Grid(symbols_),
+symbol {symbol_},
 size {def_local_size_c}, 
 scale {def_local_scale_c},
 origin(calculate_origin(location))
@@ -133,30 +166,38 @@ origin(calculate_origin(location))
 
 void Local::draw()
 {
-	// first create an empty grid
-	// TODO: this is sloppy, bad design?
-	vector< vector<string>> grid (size, vector<string>(size, ". "));
-	vector<string> outside;
-	// populate grid/outside with proper names and locations
-	Grid::populate_grid(grid, outside, size, scale, origin);
+	// populate the grid with proper names and locations
+	Grid::populate_grid(size, scale, origin);
 	// then print everything
-	cout << "Local view for: " << name << endl;
-	Grid::print_grid(grid, size, scale, origin);
+	Output::events() << "Local view for: " << get_symbols().get_name(symbol) << '\n';
+	Grid::print_grid(size, scale, origin);
+}
+
+void Local::draw_changes()
+{
+	if (!has_printed_grid()) {
+		draw();
+		return;
+	}
+	Grid::populate_grid(size, scale, origin);
+	const string& rows = Grid::get_changed_rows(size, scale, origin);
+	if (rows.empty())
+		return;
+	Output::events() << "Local view for: " << get_symbols().get_name(symbol) << '\n' << rows;
 }
 
 void Local::clear()
 {
-	name.clear();
 	Grid::clear();
 }
 
-void Local::update_location(const string& name, Point location)
+void Local::update_location(int symbol, Point location)
 {
 	// first update the location stored in the parents object list
-	Grid::update_location(name, location);
+	Grid::update_location(symbol, location);
 	// now update our own origin
 	// if our guy has changed, update the origin
-	if (name == Local::name)
+	if (symbol == Local::symbol)
 		origin = calculate_origin(location);
 }
 
@@ -182,24 +223,59 @@ static const double def_map_scale_c {2.0};
 static const double def_map_origin_x_c {-10.0};
 static const double def_map_origin_y_c {-10.0};
 
-// default constructor sets the default size, scale, and origin
-Map::Map()
+// constructor sets the default size, scale, and origin
+Map::Map(const Symbol_table& symbols_)
 :
+Grid(symbols_),
 size {def_map_size_c},
 scale {def_map_scale_c},
-origin(def_map_origin_x_c, def_map_origin_y_c)
+origin(def_map_origin_x_c, def_map_origin_y_c),
+drawn_size {0},
+drawn_scale {0},
+drawn_origin(def_map_origin_x_c, def_map_origin_y_c)
 { }
 
 // prints out the current map
 void Map::draw()
 {
-	// first create an empty grid
-	vector< vector<string>> grid (size, vector<string>(size, ". "));
-	vector<string> outside;
-	// populate grid/outside with proper names and locations
-	Grid::populate_grid(grid, outside, size, scale, origin);
+	// populate the grid/outside with proper names and locations
+	Grid::populate_grid(size, scale, origin);
+	print_outliers();
 	// then print everything
-	print_grid(grid, outside);
+	print_parameters();
+	// print everyone who's outside of the grid
+	Output::events() << outliers_line;
+	Grid::print_grid(size, scale, origin);
+	drawn_size = size;
+	drawn_scale = scale;
+	drawn_origin = origin;
+	drawn_outliers_line.swap(outliers_line);
+}
+
+void Map::draw_changes()
+{
+	if (!has_printed_grid() || size != drawn_size || scale != drawn_scale
+		|| origin.x != drawn_origin.x || origin.y != drawn_origin.y) {
+		draw();
+		return;
+	}
+	Grid::populate_grid(size, scale, origin);
+	print_outliers();
+	bool outliers_changed = outliers_line != drawn_outliers_line;
+	const string& rows = Grid::get_changed_rows(size, scale, origin);
+	if (!outliers_changed && rows.empty())
+		return;
+	print_parameters();
+	ostream& os = Output::events();
+	if (outliers_changed)
+		os << (outliers_line.empty() ? "Nothing outside the map\n" : outliers_line);
+	os << rows;
+	drawn_outliers_line.swap(outliers_line);
+}
+
+void Map::print_parameters() const
+{
+	Output::events() << "Display size: " << size << ", scale: " << scale << ", origin: " << origin << '\n';
 }
 
 // modify the display parameters
@@ -239,82 +315,315 @@ void Map::set_defaults()
 	origin = Point(def_map_origin_x_c, def_map_origin_y_c);
 }
 
-void Map::print_outliers(vector<string>& outside)
+// the outliers are sorted once, rather than kept sorted as they're found;
+// if there are none, the line is empty
+void Map::print_outliers()
 {
-	ostringstream ss;
-	copy(outside.begin(), outside.end() - 1, ostream_iterator<string>(ss, ", "));
-	ss << outside.back();
-	cout << ss.str();
-	cout << " outside the map" << endl;
-}
-
-void Map::print_grid(vector<vector<string>>& grid, vector<string>& outside)
-{
-	cout << "Display size: " << size << ", scale: " << scale << ", origin: " << origin << endl;
-	// print everyone who's outside of the grid
-	if (outside.size())
-		print_outliers(outside);
-
-	Grid::print_grid(grid, size, scale, origin);
+	outliers_line.clear();
+	vector<const string*>& outside = get_outside();
+	if (outside.empty())
+		return;
+	sort(outside.begin(), outside.end(), [](const string* lhs, const string* rhs) {return *lhs < *rhs;});
+	for (size_t i = 0; i + 1 < outside.size(); ++i) {
+		outliers_line += *outside[i];
+		outliers_line += ", ";
+	}
+	outliers_line += *outside.back();
+	outliers_line += " outside the map\n";
 }
 
 // =============================
 // === VALUES IMPLEMENTATION ===
 // =============================
 
-// display information to the user
+Values::Values(const Symbol_table& symbols_)
+:
+symbols(symbols_),
+has_drawn {false},
+listing {Listing_e::ALL},
+listing_count {0},
+ordered(Value_order {this})
+{ }
+
+void Values::print_title() const
+{
+	Output::events() << "Current " << get_title() << ":\n";
+}
+
+// display information to the user, alphabetically by name
 void Values::draw()
 {
-	cout << "--------------" << endl;
-	for(auto& itr : stored_values)
-		cout << itr.first << ": " << itr.second << endl;
-	cout << "--------------" << endl;
+	print_title();
+	if (listing != Listing_e::ALL) {
+		render_summary();
+		Output::events() << summary;
+		drawn_summary.swap(summary);
+		has_drawn = true;
+		return;
+	}
+	// the values are stored in no particular order, so sort them by name
+	vector<int> entries(stored_values.size());
+	for (int i = 0; i < stored_values.size(); ++i)
+		entries[i] = i;
+	sort(entries.begin(), entries.end(), [this](int lhs, int rhs) {
+		return symbols.get_name(stored_values.symbol_at(lhs)) < symbols.get_name(stored_values.symbol_at(rhs));
+	});
+
+	ostream& os = Output::events();
+	os << "--------------\n";
+	for(int i : entries)
+		os << symbols.get_name(stored_values.symbol_at(i)) << ": " << stored_values.value_at(i) << '\n';
+	os << "--------------\n";
+	drawn_values = stored_values;
+	has_drawn = true;
+}
+
+// look for what's been added or changed, then for what's been removed
+void Values::draw_changes()
+{
+	if (!has_drawn) {
+		draw();
+		return;
+	}
+	if (listing != Listing_e::ALL) {
+		render_summary();
+		if (summary == drawn_summary)
+			return;
+		print_title();
+		Output::events() << summary;
+		drawn_summary.swap(summary);
+		return;
+	}
+	changes.clear();
+	for (int i = 0; i < stored_values.size(); ++i) {
+		int symbol = stored_values.symbol_at(i);
+		const double* drawn = drawn_values.find(symbol);
+		if (!drawn)
+			changes.push_back(make_pair(symbol, '+'));
+		else if (*drawn != stored_values.value_at(i))
+			changes.push_back(make_pair(symbol, '~'));
+	}
+	for (int i = 0; i < drawn_values.size(); ++i) {
+		int symbol = drawn_values.symbol_at(i);
+		if (!stored_values.contains(symbol))
+			changes.push_back(make_pair(symbol, '-'));
+	}
+	if (changes.empty())
+		return;
+	sort(changes.begin(), changes.end(), [this](const pair<int, char>& lhs, const pair<int, char>& rhs) {
+		return symbols.get_name(lhs.first) < symbols.get_name(rhs.first);
+	});
+
+	print_title();
+	ostream& os = Output::events();
+	for (const pair<int, char>& change : changes) {
+		os << change.second << ' ' << symbols.get_name(change.first);
+		if (change.second != '-')
+			os << ": " << *stored_values.find(change.first);
+		os << '\n';
+	}
+	drawn_values = stored_values;
 }
 // tell value to "forget" its data
 void Values::clear()
 {
 	stored_values.clear();
+	aggregates.clear();
+	aggregate_of.clear();
+	ordered.clear();
+}
+// tell value to "forget" a specific symbol
+void Values::update_remove(int symbol)
+{
+	const double* value = stored_values.find(symbol);
+	if (!value)
+		return;
+	if (listing != Listing_e::ALL)
+		count_out(symbol, *value);
+	stored_values.erase(symbol);
 }
-// tell value to "forget" a specific name
-void Values::update_remove(const std::string& name)
+
+// while listing a summary, the old value is counted out and the new one in,
+// so a draw only has to print the aggregates
+void Values::update_value(int symbol, double value)
 {
-	stored_values.erase(name);
+	if (listing == Listing_e::ALL) {
+		stored_values.set(symbol, value);
+		return;
+	}
+	const double* old_value = stored_values.find(symbol);
+	if (old_value) {
+		if (*old_value == value)
+			return;
+		count_out(symbol, *old_value);
+	}
+	stored_values.set(symbol, value);
+	count_in(symbol, value);
 }
 
-void Values::update_value(const std::string& name, double value)
+// add x to the exact sum kept in partials, which don't overlap and are in increasing
+// order of size; each addition's rounding error is kept as a partial of its own
+static void add_exactly(vector<double>& partials, double x)
 {
-	stored_values[name] = value;
+	size_t kept = 0;
+	for (double y : partials) {
+		if (fabs(x) < fabs(y))
+			swap(x, y);
+		double high = x + y;
+		double low = y - (high - x);
+		if (low != 0.)
+			partials[kept++] = low;
+		x = high;
+	}
+	partials.resize(kept);
+	partials.push_back(x);
+}
+
+// the exact sum, rounded; the same values give the same total whatever order they came in
+static double exact_total(const vector<double>& partials)
+{
+	double total = 0.;
+	for (auto itr = partials.rbegin(); itr != partials.rend(); ++itr)
+		total += *itr;
+	return total;
+}
+
+// the aggregates are built from the values there are now, and kept up to date from then on;
+// the view is drawn in full next time
+void Values::set_listing(Listing_e listing_, int count_)
+{
+	aggregates.clear();
+	aggregate_of.clear();
+	ordered.clear();
+	listing = listing_;
+	listing_count = count_;
+	if (listing != Listing_e::ALL) {
+		for (int i = 0; i < stored_values.size(); ++i)
+			count_in(stored_values.symbol_at(i), stored_values.value_at(i));
+	}
+	drawn_values.clear();
+	drawn_summary.clear();
+	has_drawn = false;
+}
+
+// add a value, which must already be stored, to its type's aggregate, and to the order
+void Values::count_in(int symbol, double value)
+{
+	Aggregates_t::iterator itr = aggregates.insert(make_pair(string(symbols.get_type_name(symbol)), Aggregate())).first;
+	Aggregate& aggregate = itr->second;
+	++aggregate.count;
+	add_exactly(aggregate.total, value);
+	aggregate.values.insert(value);
+	aggregate_of.set(symbol, itr);
+	if (listing == Listing_e::TOP || listing == Listing_e::BOTTOM)
+		ordered.insert(symbol);
+}
+
+// take a value out again, while it's still stored, since the order looks it up
+void Values::count_out(int symbol, double value)
+{
+	const Aggregates_t::iterator* found = aggregate_of.find(symbol);
+	if (!found)
+		return;
+	// the entry goes first, as erasing it may copy the iterators, which mustn't be invalid yet
+	Aggregates_t::iterator itr = *found;
+	aggregate_of.erase(symbol);
+	ordered.erase(symbol);
+	Aggregate& aggregate = itr->second;
+	if (--aggregate.count == 0) {
+		aggregates.erase(itr);
+	} else {
+		add_exactly(aggregate.total, -value);
+		aggregate.values.erase(aggregate.values.find(value));
+	}
+}
+
+// the highest values first for TOP, the lowest first for BOTTOM, and equal ones by name
+bool Values::Value_order::operator() (int lhs, int rhs) const
+{
+	double lhs_value = *values->stored_values.find(lhs);
+	double rhs_value = *values->stored_values.find(rhs);
+	if (lhs_value != rhs_value)
+		return values->listing == Listing_e::TOP ? lhs_value > rhs_value : lhs_value < rhs_value;
+	return values->symbols.get_name(lhs) < values->symbols.get_name(rhs);
+}
+
+// add one line of the summary to it, with the numbers formatted as with fixed and setprecision(2)
+static void append_aggregate(string& summary, const string& name, int count, double total, double min, double max)
+{
+	char buffer[160];
+	int length = snprintf(buffer, sizeof(buffer), ": count %d, total %.2f, min %.2f, max %.2f, mean %.2f\n",
+		count, total, min, max, total / count);
+	summary += name;
+	summary.append(buffer, length);
+}
+
+// the aggregates by type name, then for all the values together, then the listed values
+void Values::render_summary()
+{
+	summary.assign("--------------\n");
+	int count = 0;
+	double total = 0.;
+	double min = 0.;
+	double max = 0.;
+	for (const Aggregates_t::value_type& entry : aggregates) {
+		const Aggregate& aggregate = entry.second;
+		double type_min = *aggregate.values.begin();
+		double type_max = *aggregate.values.rbegin();
+		double type_total = exact_total(aggregate.total);
+		append_aggregate(summary, entry.first, aggregate.count, type_total, type_min, type_max);
+		min = count == 0 ? type_min : std::min(min, type_min);
+		max = count == 0 ? type_max : std::max(max, type_max);
+		count += aggregate.count;
+		total += type_total;
+	}
+	if (count == 0)
+		summary += "All: count 0\n";
+	else
+		append_aggregate(summary, "All", count, total, min, max);
+	summary += "--------------\n";
+	if (listing == Listing_e::SUMMARY)
+		return;
+
+	summary += listing == Listing_e::TOP ? "Top " : "Bottom ";
+	summary += to_string(listing_count);
+	summary += ":\n";
+	char buffer[64];
+	int listed = 0;
+	for (auto itr = ordered.begin(); itr != ordered.end() && listed < listing_count; ++itr, ++listed) {
+		int length = snprintf(buffer, sizeof(buffer), ": %.2f\n", *stored_values.find(*itr));
+		summary += symbols.get_name(*itr);
+		summary.append(buffer, length);
+	}
+	summary += "--------------\n";
 }
 
 // =============================
 // === HEALTH IMPLEMENTATION ===
 // ============================= 
 
-// display information
-void Health::draw()
-{
-	cout << "Current " << "Health" << ":" << endl;
-	Values::draw();
-}
+Health::Health(const Symbol_table& symbols_)
+:
+Values(symbols_)
+{ }
+
 // update the amount of health
-void Health::update_health(const std::string& name, double health)
+void Health::update_health(int symbol, double health)
 {
-	Values::update_value(name, health);
+	Values::update_value(symbol, health);
 }
 
 // ==============================
 // === AMOUNTS IMPLEMENTATION ===
 // ==============================
 
-// display information
-void Amounts::draw()
-{
-	cout << "Current " << "Amounts" << ":" << endl;
-	Values::draw();
-}
+Amounts::Amounts(const Symbol_table& symbols_)
+:
+Values(symbols_)
+{ }
 
 // update the amount
-void Amounts::update_amount(const std::string& name, double amount)
+void Amounts::update_amount(int symbol, double amount)
 {
-	Values::update_value(name, amount);
+	Values::update_value(symbol, amount);
 }
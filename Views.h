@@ -8,8 +8,8 @@ In this file are the other 6 classes that make up the majority of the
 class hierarchy.
 There are two views that are derived directly from View: Grid and Values.
 Grid represents the top down grid-based view, its responsibilities include
-keeping track of the sim_objs which are abstracted away to just std::pairs of
-strings and points. In addition it provides the functionality to its derived
+keeping track of the sim_objs which are abstracted away to just pairs of
+symbols and points. In addition it provides the functionality to its derived
 classes to populate and display its data to users.
 
 Derived from Grid are Map and Local.
@@ -29,7 +29,7 @@ to its user.
 On the other side of the view hierarchy we have the Values class, from which
 are derived both Health and Amounts view.
 Values encapsulates data regarding sim_objects in our simulation, abstracted
-away to just pairs of strings and doubles. When asked to draw, it will output a
+away to just pairs of symbols and doubles. When asked to draw, it will output a
 nicely readable list of its data.
 
 Derived from Values are Health and Amounts
@@ -39,22 +39,57 @@ Health stores information regarding the health of specific agents.
 Amounts stores information regarding the amount of food that agents or structures
 currently have on hand.
 
+Listings: a Values view lists every value by default, but can be set to list
+(see set_listing) instead:
+	SUMMARY		for each type of object, and for all of them, the count, total,
+				minimum, maximum and mean of the values
+	TOP K		the summary, then the K highest values, highest first
+	BOTTOM K	the summary, then the K lowest values, lowest first
+Equal values are listed alphabetically by name. The summary is kept up to date as
+the values are updated and removed, rather than worked out afresh from all of
+them on every draw, so a big world can be watched cheaply; while listing
+everything, the view keeps only the values.
+
+
+All of the views identify objects by the symbol Model's Symbol_table interned their
+name as, and keep their state in Symbol_maps. The table is supplied when a view is
+constructed, and names are looked up in it only when draw() prints them.
 
 Usage: 
-1. Call the update_location function with the name and position of each object
+1. Call the update_location function with the symbol and position of each object
 to be plotted. If the object is not already in the View's memory, it will be added
 along with its location. If it is already present, its location will be set to the 
 supplied location. If a single object changes location, its location can be separately
 updated with a call to update_location. 
-2. Call the update_remove function with the name of any object that should no longer
+2. Call the update_remove function with the symbol of any object that should no longer
 be plotted. This must be done *after* any call to update_location that 
 has the same object name since update_location will add any object name supplied.
 3. Call the draw function to print out the map.
+
+Drawing changes: draw_changes prints only what has changed since the view was
+last drawn, either way. A view with no changes prints nothing at all; otherwise
+it prints its usual title line ("Local view for: NAME", the Map's "Display size"
+line, "Current Health:" or "Current Amounts:"), followed by one line per change:
+	@ ROW TEXT		grid row ROW now reads TEXT; the rows are numbered from 0 at the
+					top as printed, and the row of x labels at the bottom is row size
+	+ NAME: VALUE	a value for NAME has been added
+	~ NAME: VALUE	the value for NAME has changed
+	- NAME			the value for NAME has been removed
+The value lines are in alphabetical order by name, and the grid rows from the top.
+A Values view that lists a summary has no lines for single changes: if anything
+it lists has changed, it prints the whole listing again.
+On the Map, if the objects outside the map have changed, the line listing them
+comes before the rows, as in a full draw, or "Nothing outside the map" if there
+are none now. A view that has never been drawn, or a Map whose size, scale or
+origin has changed since, is drawn in full instead.
 */
 #include <map>
+#include <set>
 #include <string>
+#include <utility>
 #include <vector>
 #include "Geometry.h"
+#include "Symbol_table.h"
 #include "View.h"
 
 // Grid is an abstract base class to provide an implementation for derived classes
@@ -63,26 +98,57 @@ has the same object name since update_location will add any object name supplied
 // to all grid based classes
 class Grid : public View {
 public:
+	// names are looked up in symbols_ when drawing
+	Grid(const Symbol_table& symbols_);
 	// tells the view to "forget" all the information it has
 	void clear() override;
-	// Save the supplied name and location for future use in a draw() call
-	// If the name is already present, the new location replaces the previous one.
-	void update_location(const std::string& name, Point location) override;
-	// Remove the name and its location; no error if the name is not present.
-	void update_remove(const std::string& name) override;
+	// Save the supplied symbol and location for future use in a draw() call
+	// If the symbol is already present, the new location replaces the previous one.
+	void update_location(int symbol, Point location) override;
+	// Remove the symbol and its location; no error if the symbol is not present.
+	void update_remove(int symbol) override;
 
 protected:
+	const Symbol_table& get_symbols() const
+		{return symbols;}
+
 	// since populating and printing the grid is shared functionality
 	// they're provided here as protected to avoid duplicating code
 	// between Local and Map
 	bool get_subscripts(int &ix, int &iy, Point location, const int& size, const double& scale, const Point& origin);
-	// populates grid with outliers in a serparate vector
-	void populate_grid(std::vector<std::vector<std::string>>& grid, std::vector<std::string>& outside, const int& size, const double& scale, const Point& origin);
+	// work out which objects are in which cell of the grid, in one pass over them,
+	// and which are outside it; the names of those are kept in no particular order
+	void populate_grid(const int& size, const double& scale, const Point& origin);
+	// the names of the objects outside the grid, since it was last populated
+	std::vector<const std::string*>& get_outside()
+		{return outside;}
 	// print the grid and just the grid
-	void print_grid(std::vector<std::vector<std::string>>& grid, const int& size, const double& scale, const Point& origin);
+	void print_grid(const int& size, const double& scale, const Point& origin);
+	// has the grid been printed yet?
+	bool has_printed_grid() const
+		{return !drawn_frame.empty();}
+	// the rows of the grid that are different from when it was last printed,
+	// in the format described above, or an empty string if none are;
+	// from then on, the grid counts as printed
+	const std::string& get_changed_rows(const int& size, const double& scale, const Point& origin);
 
 private:
-	std::map<std::string, Point> object_list;	
+	const Symbol_table& symbols;
+	Symbol_map<Point> object_list;
+
+	// The storage for drawing is kept from one draw to the next, so that drawing
+	// doesn't allocate once it has drawn a grid as big before.
+	// what's in each cell, row by row from the bottom: the position in object_list
+	// of the only object there, or whether there are none or several
+	std::vector<int> cells;
+	std::vector<const std::string*> outside;
+	// the grid is printed into frame, and frame written out in one go;
+	// drawn_frame is the grid as it was last printed, and changes its changed rows
+	std::string frame;
+	std::string drawn_frame;
+	std::string changes;
+
+	void render_grid(const int& size, const double& scale, const Point& origin);
 };
 
 // local and map, two of the grid views are responsible
@@ -90,22 +156,23 @@ private:
 // well as printing their data
 class Local : public Grid {
 public:
-	// default constructor sets default size, scale, and origin
-	Local(Point origin_, std::string name);
+	// constructor sets default size, scale, and origin, centered on the object
+	Local(Point origin_, int symbol_, const Symbol_table& symbols_);
 	
 	// prints out the current map
 	void draw() override;
+	void draw_changes() override;
 	// tells the view to "forget" all the information it has
 	void clear() override;
 	// update the origin to match the objects new location
-	void update_location(const std::string& name, Point location) override;
+	void update_location(int symbol, Point location) override;
 
 private:
 	// given the location of the current object, calculates the correct
 	// poisition of the origin relative to that location
 	Point calculate_origin(Point location);
-	// name of the person who is being displayed
-	std::string name;
+	// symbol of the person who is being displayed
+	int symbol;
 
 	int size;
 	double scale;
@@ -114,11 +181,12 @@ private:
 
 class Map : public Grid {
 public:
-	// default constructor sets the default size, scale, and origin
-	Map(); 
+	// constructor sets the default size, scale, and origin
+	Map(const Symbol_table& symbols_);
 	
 	// prints out the current map
 	void draw() override;
+	void draw_changes() override;
 	
 	// modify the display parameters
 	// if the size is out of bounds will throw Error("New map size is too big!")
@@ -129,49 +197,107 @@ public:
 	void set_defaults() override;
 
 private:
-	void print_grid(std::vector< std::vector<std::string> >& grid, std::vector<std::string>& outside);
-	void print_outliers(std::vector<std::string>& outside);
+	// print the names of the objects outside the grid, alphabetically, into outliers_line
+	void print_outliers();
+	// print the Display size line
+	void print_parameters() const;
 
 	int size;
 	double scale;
 	Point origin;
+	// the parameters and the line of outliers as they were last drawn
+	int drawn_size;
+	double drawn_scale;
+	Point drawn_origin;
+	std::string outliers_line;
+	std::string drawn_outliers_line;
 }; 
 
 // Values is responsible for maintaining an std::map of names to values (doubles)
 // it is also responsible for neatly printing its contents to the user
 class Values : public View {
 public:
-	// display information to the user
+	// names are looked up in symbols_ when drawing
+	Values(const Symbol_table& symbols_);
+	// display information to the user, alphabetically by name
 	void draw() override;
+	// display the values added, changed and removed since the last draw, alphabetically by name
+	void draw_changes() override;
 	// tell value to "forget" its data
 	void clear() override;
-	// tell value to "forget" a specific name
-	void update_remove(const std::string& name) override;
+	// tell value to "forget" a specific symbol
+	void update_remove(int symbol) override;
+	// list every value, or a summary and perhaps the count highest or lowest values
+	void set_listing(Listing_e listing_, int count_) override;
 
 protected:
-	void update_value(const std::string& name, double value);
+	void update_value(int symbol, double value);
+	// the title line's name for what the values are
+	virtual const char* get_title() const = 0;
 
 private:
-	std::map<std::string, double> stored_values;
+	const Symbol_table& symbols;
+	Symbol_map<double> stored_values;
+	// the values as they were last drawn, and whether they have been
+	Symbol_map<double> drawn_values;
+	bool has_drawn;
+	// the changes since, as symbols and kinds of change, kept from one draw to the next
+	std::vector<std::pair<int, char>> changes;
+
+	Listing_e listing;
+	int listing_count;
+	// the values of one type of object; the values themselves are kept, in order,
+	// so that the minimum and maximum are still known after one is removed, and the
+	// total is kept exactly, as partial sums, so that it doesn't drift as values come and go
+	struct Aggregate {
+		int count = 0;
+		std::vector<double> total;
+		std::multiset<double> values;
+	};
+	// while listing a summary, the aggregates by type name, and the one each value is
+	// counted in; a type's aggregate is removed along with its last value
+	using Aggregates_t = std::map<std::string, Aggregate>;
+	Aggregates_t aggregates;
+	Symbol_map<Aggregates_t::iterator> aggregate_of;
+	// while listing the highest or lowest values, the symbols in the order they're listed
+	struct Value_order {
+		const Values* values;
+		bool operator() (int lhs, int rhs) const;
+	};
+	std::set<int, Value_order> ordered;
+	// the listing is printed into summary, and drawn_summary is as it was last printed
+	std::string summary;
+	std::string drawn_summary;
+
+	void print_title() const;
+	void count_in(int symbol, double value);
+	void count_out(int symbol, double value);
+	void render_summary();
 };
 
 // Health keeps track of the health of agents in the simulation
 class Health : public Values {
 public:
-	// display information
-	void draw() override;
+	Health(const Symbol_table& symbols_);
 	// update the amount of health
-	void update_health(const std::string& name, double health) override;
+	void update_health(int symbol, double health) override;
+
+protected:
+	const char* get_title() const override
+		{return "Health";}
 };
 
 // Amounts keeps track of the amount of food that is being carried by an agent,
 // or stored in a structure
 class Amounts : public Values {
 public:
-	// display information
-	void draw() override;
+	Amounts(const Symbol_table& symbols_);
 	// update the amount
-	void update_amount(const std::string& name, double amount) override;
+	void update_amount(int symbol, double amount) override;
+
+protected:
+	const char* get_title() const override
+		{return "Amounts";}
 };
 
 #endif
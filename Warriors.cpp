@@ -1,11 +1,13 @@
 #include "Warriors.h"
 
+#include "Checkpoint.h"
+#include "Event_stream.h"
 #include "Geometry.h"
 #include "Model.h"
+#include "Output.h"
 #include "Structure.h"
 #include "Utility.h"
 
-#include <iostream>
 using namespace std;
 
 Warrior::Warrior(const std::string& name_, Point location_, int attack_strength_, int attack_range_, const char* attack_noise_)
@@ -13,41 +15,38 @@ Warrior::Warrior(const std::string& name_, Point location_, int attack_strength_
 Agent(name_, location_),
 attack_state {Attack_State_e::NOT_ATTACKING},
 attack_strength {attack_strength_},
-attack_range {attack_range_}
-{
-	attack_noise = new string(attack_noise_);
-}
-
-Warrior::~Warrior()
-{
-	delete attack_noise;
-}
+attack_range {attack_range_},
+attack_noise {attack_noise_}
+{ }
 
-// update implements Warrior behavior
-void Warrior::update()
+// update_behavior implements Warrior behavior
+void Warrior::update_behavior()
 {
-	Agent::update();
+	PROFILE_PHASE(get_model(), COMBAT);
 	if (!Agent::is_alive() || attack_state == Attack_State_e::NOT_ATTACKING)
 		return;
 	
 	shared_ptr<Agent> shared_target = target.lock();
 	if (target.expired() || !shared_target->is_alive())  {
-		cout << get_name() << ": Target is dead" << endl;
+		Output::chatter() << get_name() << ": Target is dead\n";
 		attack_state = Attack_State_e::NOT_ATTACKING;
 		target.reset();
 		return;
 	}
 	// else we're attacking
-	if (cartesian_distance(get_location(), shared_target->get_location()) > attack_range) {
-		cout << get_name() << ": Target is now out of range" << endl;
+	Model& model = get_model();
+	if (cartesian_distance(model.get_observed_location(*this), model.get_observed_location(*shared_target)) > attack_range) {
+		Output::chatter() << get_name() << ": Target is now out of range\n";
 		attack_state = Attack_State_e::NOT_ATTACKING;
 		target.reset();
 		return;
 	}
-	cout << get_name() << ": " << *attack_noise << endl;
+	Output::chatter() << get_name() << ": " << attack_noise << '\n';
+	if (Event_stream* events = model.get_event_stream())
+		events->record_attacked(get_symbol(), shared_target->get_symbol());
 	shared_target->take_hit(attack_strength, shared_from_this());
 	if (!shared_target || !shared_target->is_alive()) {
-		cout << get_name() << ": I triumph!" << endl;
+		Output::chatter() << get_name() << ": I triumph!\n";
 		attack_state = Attack_State_e::NOT_ATTACKING;
 		target.reset();
 	}
@@ -64,7 +63,8 @@ void Warrior::start_attacking(shared_ptr<Agent> target_ptr)
 	if (!target_ptr->is_alive())
 		throw Error(get_name() + ": Target is not alive!");
 
-	if (cartesian_distance (get_location(), target_ptr->get_location()) > attack_range)
+	Model& model = get_model();
+	if (cartesian_distance (model.get_observed_location(*this), model.get_observed_location(*target_ptr)) > attack_range)
 		throw Error(get_name() + ": Target is out of range!");
 
 	attack(target_ptr);
@@ -79,7 +79,7 @@ void Warrior::take_hit(int attack_strength, shared_ptr<Agent> attacker_ptr)
 // Overrides Agent's stop to print a message
 void Warrior::stop()
 {
-	cout << get_name() << ": Don't bother me" << endl;
+	Output::chatter() << get_name() << ": Don't bother me\n";
 }
 
 // output information about the current state
@@ -88,12 +88,12 @@ void Warrior::describe() const
 	Agent::describe();
 	if (attack_state == Attack_State_e::ATTACKING) {
 		if (target.expired())
-			cout << "   Attacking dead target" << endl;
+			Output::events() << "   Attacking dead target\n";
 		else
-			cout << "   Attacking " << target.lock()->get_name() << endl;
+			Output::events() << "   Attacking " << target.lock()->get_name() << '\n';
 	}
 	else
-		cout << "   Not attacking" << endl;
+		Output::events() << "   Not attacking\n";
 }
 
 void Warrior::reset_attacking()
@@ -105,8 +105,29 @@ void Warrior::reset_attacking()
 void Warrior::attack(shared_ptr<Agent> target_ptr)
 {
 	target = target_ptr;
-	cout << get_name() << ": I'm attacking!" << endl;
+	Output::chatter() << get_name() << ": I'm attacking!\n";
 	attack_state = Attack_State_e::ATTACKING;
+	get_model().activate(get_id());
+}
+
+// also saves the attack state and the target; a target that has died is saved as none
+void Warrior::save_state(Checkpoint_record& record, const Checkpoint_links& links) const
+{
+	Agent::save_state(record, links);
+	record.state = int32_t(attack_state);
+	record.link_1 = links.record_of(target.lock().get());
+}
+
+void Warrior::restore_state(const Checkpoint_record& record, const Checkpoint_links& links)
+{
+	Agent::restore_state(record, links);
+	if (record.state < int32_t(Attack_State_e::ATTACKING) || record.state > int32_t(Attack_State_e::NOT_ATTACKING))
+		throw Error("Checkpoint file is corrupt!");
+	attack_state = Attack_State_e(record.state);
+	shared_ptr<Sim_object> object = links.object_at(record.link_1);
+	target = dynamic_pointer_cast<Agent>(object);
+	if (object && target.expired())
+		throw Error("Checkpoint file is corrupt!");
 }
 
 // ==============================
@@ -139,7 +160,7 @@ void Soldier::take_hit(int attack_strength, std::shared_ptr<Agent> attacker_ptr)
 
 void Soldier::describe() const
 {
-	cout << "Soldier ";
+	Output::events() << "Soldier ";
 	Warrior::describe();
 }
 
@@ -156,13 +177,15 @@ Archer::Archer(const std::string& name_, Point location_)
 Warrior(name_, location_, def_archer_strength_c, def_archer_range_c, twang_c)
 {}
 
-void Archer::update()
+void Archer::update_behavior()
 {
-	Warrior::update();
+	PROFILE_PHASE(get_model(), COMBAT);
+	Warrior::update_behavior();
 	if (!Warrior::is_attacking()) {
 		// find next target
-		shared_ptr<Agent> target = Model::get_Model().get_closest_agent(shared_from_this());
-		if(cartesian_distance(get_location(), target->get_location()) <= def_archer_range_c) {
+		Model& model = get_model();
+		shared_ptr<Agent> target = model.get_closest_agent(shared_from_this());
+		if(cartesian_distance(model.get_observed_location(*this), model.get_observed_location(*target)) <= def_archer_range_c) {
 			// new target is within range, attack!
 			start_attacking(target);
 		}
@@ -176,13 +199,16 @@ void Archer::take_hit(int attack_strength, std::shared_ptr<Agent> attacker_ptr)
 	if (!is_alive())
 		return;
 	// find the closest structure and run there
-	shared_ptr<Structure> closest_bld = Model::get_Model().get_closest_structure(shared_from_this());
-	cout << get_name() << ": I'm going to run away to " << closest_bld->get_name() << endl;
+	shared_ptr<Structure> closest_bld = get_model().get_closest_structure(shared_from_this());
+	// nowhere to run to
+	if (!closest_bld)
+		return;
+	Output::chatter() << get_name() << ": I'm going to run away to " << closest_bld->get_name() << '\n';
 	move_to(closest_bld->get_location());
 }
 
 void Archer::describe() const
 {
-	cout << "Archer ";
+	Output::events() << "Archer ";
 	Warrior::describe();
 }
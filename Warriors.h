@@ -18,10 +18,15 @@ class Warrior : public Agent {
 public:
 	
 	Warrior(const std::string& name_, Point location_, int attack_strength, int attack_range, const char* attack_noise);
-	~Warrior();
 	
-	// update implements Soldier behavior
-	void update() override;
+	// update_behavior implements Warrior behavior
+	void update_behavior() override;
+	// also has something to do while attacking
+	bool has_pending_work() const override
+		{return Agent::has_pending_work() || (is_alive() && attack_state == Attack_State_e::ATTACKING);}
+	// while attacking, every tick looks at the target
+	int get_skippable_ticks(int ticks) const override
+		{return is_alive() && attack_state == Attack_State_e::ATTACKING ? 0 : Agent::get_skippable_ticks(ticks);}
 	
 	// Make this Soldier start attacking the target Agent.
 	// Throws an exception if the target is the same as this Agent,
@@ -41,6 +46,10 @@ public:
 	bool is_attacking()
 	{return attack_state == Attack_State_e::ATTACKING;}
 
+	// also saves the attack state and the target
+	void save_state(Checkpoint_record& record, const Checkpoint_links& links) const override;
+	void restore_state(const Checkpoint_record& record, const Checkpoint_links& links) override;
+
 protected:
 
 	// will set the warriors state to not attacking and forget its target
@@ -56,7 +65,8 @@ private:
 	int attack_strength;
 	int attack_range;
 	std::weak_ptr<Agent> target;
-	std::string* attack_noise;
+	// a string literal, so nothing to allocate or free
+	const char* attack_noise;
 };
 
 /*
@@ -69,6 +79,8 @@ public:
 	Soldier(const std::string& name_, Point location_);
 	// loses health, and attacks its aggressor
 	void take_hit(int attack_strength, std::shared_ptr<Agent> attack_ptr) override;
+	const char* get_type_name() const override
+		{return "Soldier";}
 	// outputs soldier and then calls warrior's describe
 	void describe() const override;
 };
@@ -82,9 +94,17 @@ class Archer : public Warrior {
 public:
 	Archer(const std::string& name_, Point location_);
 	// unless he's attacking, will find the closest agent and attack him if in range
-	void update() override;
+	void update_behavior() override;
+	// always on the lookout while alive
+	bool has_pending_work() const override
+		{return is_alive();}
+	// every tick, looks around for a target
+	int get_skippable_ticks(int ticks) const override
+		{return is_alive() ? 0 : ticks;}
 	// runs to the closest structure if its in range
 	void take_hit(int attack_strength, std::shared_ptr<Agent> attack_ptr) override;
+	const char* get_type_name() const override
+		{return "Archer";}
 	// outputs archer and then calls warriors describe
 	void describe() const override;
 };